@@ -5,106 +5,84 @@
 #include <stdbool.h>
 #include "wordhash.h"
 
-HashEntry hash_table[TABLE_SIZE]; //declare hash table
+//Keywords, reserved words, noise words and constants in a static perfect
+//hash: every word has a slot of its own, so a lookup is one hash, one
+//length check and one memcmp. Change the word list in tools/wordgen.c and
+//paste its output here.
 
-//hash function
-unsigned int hash(const char *key) {
-    unsigned int hash_val = 5381;
-    int c;
-       while ((c = *key++)) {
-        hash_val = hash_val * 33 + c;
-    }
-    return hash_val % TABLE_SIZE;
-}
-
-// hashInsert key/moise/reserve word into hash table
-void hashInsert(const char *key, TokenCategory category, int token_value) {
-    unsigned int index = hash(key);
-    unsigned int start = index;
-
-    do {
-        if (hash_table[index].key[0] == '\0') {
-            strcpy(hash_table[index].key, key);
-            hash_table[index].category = category;
-            hash_table[index].tokenValue = token_value;
-            return;
-        }
-        index = (index + 1) % TABLE_SIZE;
-    } while (index != start);
+// ---- generated by tools/wordgen.c, do not edit by hand ----
+#define WORD_SLOTS 64
+#define WORD_MIN_LENGTH 2
+#define WORD_MAX_LENGTH 17
+#define WORD_HASH(first, second, last, length) \
+    (((first) * 17u + (second) * 18u + (last) * 63u + (length)) & (WORD_SLOTS - 1))
 
-    fprintf(stderr, "Error: hash table full\n");
-    exit(1);
-}
+static const HashEntry wordTable[WORD_SLOTS] = {
+    [ 0] = {"gawin", 5, CAT_KEYWORD, K_GAWIN},
+    [ 2] = {"publiko", 7, CAT_KEYWORD, K_PUBLIKO},
+    [ 3] = {"bilang", 6, CAT_RESERVED, R_BILANG},
+    [ 5] = {"lutang", 6, CAT_RESERVED, R_LUTANG},
+    [ 6] = {"itakda", 6, CAT_NOISEWORD, N_ITAKDA},
+    [ 7] = {"ani", 3, CAT_KEYWORD, K_ANI},
+    [ 9] = {"ang", 3, CAT_NOISEWORD, N_ANG},
+    [11] = {"wakas", 5, CAT_NOISEWORD, N_WAKAS},
+    [12] = {"pribado", 7, CAT_KEYWORD, K_PRIBADO},
+    [13] = {"kwerdas", 7, CAT_RESERVED, R_KWERDAS},
+    [14] = {"kiss", 4, CAT_RESERVED, R_Kiss},
+    [15] = {"protektado", 10, CAT_KEYWORD, K_PROTEKTADO},
+    [18] = {"doble", 5, CAT_RESERVED, R_DOBLE},
+    [19] = {"ugat", 4, CAT_RESERVED, R_UGAT},
+    [20] = {"bulyan", 6, CAT_RESERVED, R_BULYAN},
+    [21] = {"pangkat", 7, CAT_KEYWORD, K_PANGKAT},
+    [22] = {"sa", 2, CAT_NOISEWORD, N_SA},
+    [25] = {"habang", 6, CAT_KEYWORD, K_HABANG},
+    [26] = {"mula", 4, CAT_NOISEWORD, N_MULA},
+    [27] = {"E_num", 5, CAT_RESERVED, R_E_NUM},
+    [28] = {"wala", 4, CAT_RESERVED, R_WALA},
+    [30] = {"tanim", 5, CAT_KEYWORD, K_TANIM},
+    [31] = {"sampleConstString", 17, CAT_RESERVED, R_SAMPLE_CONST_STRING},
+    [32] = {"bunga", 5, CAT_NOISEWORD, N_BUNGA},
+    [37] = {"para", 4, CAT_KEYWORD, K_PARA},
+    [38] = {"statik", 6, CAT_KEYWORD, K_STATIK},
+    [39] = {"ng", 2, CAT_NOISEWORD, N_NG},
+    [41] = {"tama", 4, CAT_RESERVED, R_TAMA},
+    [42] = {"mali", 4, CAT_RESERVED, R_MALI},
+    [43] = {"pi", 2, CAT_RESERVED, R_PI},
+    [46] = {"balik", 5, CAT_RESERVED, R_BALIK},
+    [47] = {"kundiman", 8, CAT_KEYWORD, K_KUNDIMAN},
+    [48] = {"titik", 5, CAT_RESERVED, R_TITIK},
+    [49] = {"kundi", 5, CAT_KEYWORD, K_KUNDI},
+    [50] = {"kung", 4, CAT_KEYWORD, K_KUNG},
+    [52] = {"tibag", 5, CAT_KEYWORD, K_TIBAG},
+    [58] = {"tuloy", 5, CAT_KEYWORD, K_TULOY},
+    [60] = {"ay", 2, CAT_NOISEWORD, N_AY},
+};
+// ---- end of generated block ----
 
-// Lookup a key in the hash table
-HashEntry *hashLookUp(const char *key) {
-    unsigned int index = hash(key);
-    unsigned int start = index;
+// Lookup a word given as pointer + length (no NUL needed)
+const HashEntry *wordLookup(const char *text, size_t length) {
+    const unsigned char *p = (const unsigned char *)text;
+    const HashEntry *entry;
 
-    do {
-        if (hash_table[index].key[0] == '\0') {
-            return NULL;
-        }
-        if (strcmp(hash_table[index].key, key) == 0) {
-            return &hash_table[index];
-        }
-        index = (index + 1) % TABLE_SIZE;
-    } while (index != start);
+    //too short or too long to be any word
+    if (length < WORD_MIN_LENGTH || length > WORD_MAX_LENGTH)
+        return NULL;
 
-    return NULL;
+    entry = &wordTable[WORD_HASH(p[0], p[1], p[length - 1], length)];
+    //empty slots have length 0
+    if (entry->length != length || memcmp(entry->key, text, length) != 0)
+        return NULL;
+    return entry;
 }
 
-void initialize_table(void) {
-    // Keywords
-    hashInsert("ani", CAT_KEYWORD, K_ANI);
-    hashInsert("tanim", CAT_KEYWORD, K_TANIM);
-    hashInsert("para", CAT_KEYWORD, K_PARA);
-    hashInsert("habang", CAT_KEYWORD, K_HABANG);
-    hashInsert("kung", CAT_KEYWORD, K_KUNG);
-    hashInsert("kundi", CAT_KEYWORD, K_KUNDI);
-    hashInsert("kundiman", CAT_KEYWORD, K_KUNDIMAN);
-    hashInsert("gawin", CAT_KEYWORD, K_GAWIN);
-    hashInsert("tibag", CAT_KEYWORD, K_TIBAG);
-    hashInsert("tuloy", CAT_KEYWORD, K_TULOY);
-    hashInsert("pangkat", CAT_KEYWORD, K_PANGKAT);
-    hashInsert("statik", CAT_KEYWORD, K_STATIK);
-    hashInsert("pribado", CAT_KEYWORD, K_PRIBADO);
-    hashInsert("protektado", CAT_KEYWORD, K_PROTEKTADO);
-    hashInsert("publiko", CAT_KEYWORD, K_PUBLIKO);
-
-    // Reserved words
-    hashInsert("tama", CAT_RESERVED, R_TAMA);
-    hashInsert("mali", CAT_RESERVED, R_MALI);
-    hashInsert("ugat", CAT_RESERVED, R_UGAT);
-    hashInsert("balik", CAT_RESERVED, R_BALIK);
-    hashInsert("bilang", CAT_RESERVED, R_BILANG);
-    hashInsert("kwerdas", CAT_RESERVED, R_KWERDAS);
-    hashInsert("titik", CAT_RESERVED, R_TITIK);
-    hashInsert("lutang", CAT_RESERVED, R_LUTANG);
-    hashInsert("bulyan", CAT_RESERVED, R_BULYAN);
-    hashInsert("doble", CAT_RESERVED, R_DOBLE);
-    hashInsert("wala", CAT_RESERVED, R_WALA);
-
-    // Noise words
-    hashInsert("ng", CAT_NOISEWORD, N_NG);
-    hashInsert("ay", CAT_NOISEWORD, N_AY);
-    hashInsert("bunga", CAT_NOISEWORD, N_BUNGA);
-    hashInsert("wakas", CAT_NOISEWORD, N_WAKAS);
-    hashInsert("sa", CAT_NOISEWORD, N_SA);
-    hashInsert("ang", CAT_NOISEWORD, N_ANG);
-    hashInsert("mula", CAT_NOISEWORD, N_MULA);
-    hashInsert("itakda", CAT_NOISEWORD, N_ITAKDA);
-    //Const
-    hashInsert("pi", CAT_RESERVED, R_PI);
-    hashInsert("E_num", CAT_RESERVED, R_E_NUM);
-    hashInsert("kiss", CAT_RESERVED, R_Kiss);
-    hashInsert("sampleConstString", CAT_RESERVED, R_SAMPLE_CONST_STRING);
-    
+// Lookup a NUL terminated key
+const HashEntry *hashLookUp(const char *key) {
+    return wordLookup(key, strlen(key));
 }
 
 // Added for parser
 int hashLookup(const char *lexeme, int *category, int *value) {
-    HashEntry *entry = hashLookUp(lexeme);
+    const HashEntry *entry = hashLookUp(lexeme);
     
     if (entry != NULL) {
         *category = entry->category;
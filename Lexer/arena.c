@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "arena.h"
+
+#define ARENA_ALIGN 16
+
+void arenaInit(Arena *arena, size_t blockSize) {
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->blockSize = blockSize ? blockSize : ARENA_DEFAULT_BLOCK;
+}
+
+static ArenaBlock *newBlock(size_t size) {
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + size);
+    if (!block) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+//offset in block where size bytes at the given alignment fit, or -1
+static size_t fitAt(const ArenaBlock *block, size_t size, size_t align) {
+    uintptr_t base = (uintptr_t)block->data;
+    size_t start = (size_t)(((base + block->used + align - 1) & ~(uintptr_t)(align - 1)) - base);
+    return start + size <= block->size ? start : (size_t)-1;
+}
+
+//find room for size bytes, moving on to the next kept block (after a
+//reset) or a new one when the current block is full
+static void *take(Arena *arena, size_t size, size_t align) {
+    ArenaBlock *block = arena->current;
+    size_t start;
+
+    while (block) {
+        start = fitAt(block, size, align);
+        if (start != (size_t)-1) {
+            block->used = start + size;
+            return block->data + start;
+        }
+        if (!block->next)
+            break;
+        block = block->next;
+        block->used = 0;
+        arena->current = block;
+    }
+
+    //oversized requests get a block of their own
+    size_t need = size + align;
+    ArenaBlock *fresh = newBlock(need > arena->blockSize ? need : arena->blockSize);
+    if (block)
+        block->next = fresh;
+    else
+        arena->first = fresh;
+    arena->current = fresh;
+    start = fitAt(fresh, size, align);
+    fresh->used = start + size;
+    return fresh->data + start;
+}
+
+void *arenaAlloc(Arena *arena, size_t size) {
+    return take(arena, size, ARENA_ALIGN);
+}
+
+char *arenaStrndup(Arena *arena, const char *text, size_t len) {
+    char *copy = take(arena, len + 1, 1);
+    memcpy(copy, text, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+void arenaReset(Arena *arena) {
+    arena->current = arena->first;
+    if (arena->first)
+        arena->first->used = 0;
+}
+
+void arenaFree(Arena *arena) {
+    ArenaBlock *block = arena->first;
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+}
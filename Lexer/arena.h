@@ -0,0 +1,37 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+//Bump allocator: memory is handed out from big blocks and given back all at
+//once. arenaReset() keeps the blocks so the next run reuses the same pages.
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;   // usable bytes in data
+    size_t used;   // bytes handed out so far
+    char data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *first;    // oldest block, start of the chain
+    ArenaBlock *current;  // block allocations come from
+    size_t blockSize;     // size of a normal block
+} Arena;
+
+#define ARENA_DEFAULT_BLOCK (64 * 1024)
+
+void arenaInit(Arena *arena, size_t blockSize);
+
+//aligned for any type, exits on out of memory like the rest of the lexer
+void *arenaAlloc(Arena *arena, size_t size);
+
+//copy of len bytes of text plus a terminating NUL (no alignment padding)
+char *arenaStrndup(Arena *arena, const char *text, size_t len);
+
+//forget every allocation but keep the blocks
+void arenaReset(Arena *arena);
+
+//give every block back to the system
+void arenaFree(Arena *arena);
+
+#endif
@@ -0,0 +1,412 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include "lexer.h"
+#include "wordhash.h"
+#include "simdscan.h"
+
+#define LEXER_STATES (S_DONE + 1)
+
+//Character classes: every byte is sorted into one of these by charClass[]
+typedef enum {
+    CC_OTHER,        // anything not listed below (@ $ ? : non-ASCII ...)
+    CC_ALPHA,        // a-z A-Z
+    CC_DIGIT,        // 0-9
+    CC_UNDERSCORE,   // _
+    CC_SPACE,        // blank, \t \v \f \r
+    CC_NEWLINE,      // \n
+    CC_DQUOTE,       // "
+    CC_SQUOTE,       // '
+    CC_SLASH,        // /
+    CC_STAR,         // *
+    CC_AMP,          // &
+    CC_PIPE,         // |
+    CC_EQUAL,        // =
+    CC_BANG,         // !
+    CC_LESS,         // <
+    CC_GREATER,      // >
+    CC_PLUS,         // +
+    CC_MINUS,        // -
+    CC_CARET,        // ^
+    CC_PERCENT,      // %
+    CC_DOT,          // .
+    CC_SEMICOLON,    // ;
+    CC_LBRACE,       // {
+    CC_RBRACE,       // }
+    CC_LPAREN,       // (
+    CC_RPAREN,       // )
+    CC_LBRACKET,     // [
+    CC_RBRACKET,     // ]
+    CC_COMMA,        // ,
+    CC_NUL,          // \0 (ends an unknown lexeme, like the old strchr check)
+    CC_EOF,          // end of input (never stored in charClass[])
+    CHAR_CLASSES,
+    CC_ANY = CHAR_CLASSES // rule wildcard: default for every class of a state
+} CharClass;
+
+//Actions done on a transition, applied in this order. Nothing is copied:
+//every consumed character that is not pushed back belongs to the lexeme.
+enum {
+    A_BEGIN  = 1 << 0,  // new lexeme starts at this character, remember line
+    A_BACK   = 1 << 1,  // do not consume the character, next state reads it again
+    A_LINE   = 1 << 2,  // count a line
+    A_EMIT   = 1 << 3,  // lexeme is done: make the token of the transition
+    A_LOOKUP = 1 << 4,  // with A_EMIT: keyword/reserved/noise word or identifier
+    A_STOP   = 1 << 5   // end of input, leave lexer()
+};
+
+typedef struct {
+    unsigned char next;        // LexerState to go to
+    unsigned char action;      // A_* flags
+    unsigned char category;    // TokenCategory made by A_EMIT
+    unsigned char tokenValue;  // token kind made by A_EMIT
+} LexTransition;
+
+//One row of the DFA description, CC_ANY rows give the default of a state
+typedef struct {
+    LexerState from;
+    CharClass on;
+    LexerState to;
+    unsigned char action;
+    TokenCategory category;
+    int tokenValue;
+} LexRule;
+
+//Final states that need no lookahead (single char operators, delimiters,
+//closing quotes, ==, &&, ...) are not visited: the transition into them emits.
+static const LexRule lexRules[] = {
+    //from                  on             to                    action                       token
+    { S_START,              CC_ANY,        S_UNKNOWN,            A_BEGIN,                     0,             0 },
+    { S_START,              CC_EOF,        S_START,              A_STOP,                      0,             0 },
+    { S_START,              CC_SPACE,      S_START,              0,                           0,             0 },
+    { S_START,              CC_NEWLINE,    S_START,              A_LINE,                      0,             0 },
+    { S_START,              CC_ALPHA,      S_IDENTIFIER,         A_BEGIN,                     0,             0 },
+    { S_START,              CC_UNDERSCORE, S_UNKNOWN,            A_BEGIN,                     0,             0 },
+    { S_START,              CC_DIGIT,      S_NUMBER_BILANG,      A_BEGIN,                     0,             0 },
+    { S_START,              CC_DQUOTE,     S_KWERDAS_HEAD,       A_BEGIN,                     0,             0 },
+    { S_START,              CC_SQUOTE,     S_TITIK_HEAD,         A_BEGIN,                     0,             0 },
+    { S_START,              CC_SLASH,      S_OP_DIVIDE_HEAD,     A_BEGIN,                     0,             0 },
+    { S_START,              CC_AMP,        S_OP_AND_HEAD,        A_BEGIN,                     0,             0 },
+    { S_START,              CC_PIPE,       S_OP_OR_HEAD,         A_BEGIN,                     0,             0 },
+    { S_START,              CC_EQUAL,      S_OP_ASSIGN_HEAD,     A_BEGIN,                     0,             0 },
+    { S_START,              CC_BANG,       S_OP_NOT_HEAD,        A_BEGIN,                     0,             0 },
+    { S_START,              CC_LESS,       S_OP_LESS_HEAD,       A_BEGIN,                     0,             0 },
+    { S_START,              CC_GREATER,    S_OP_GREATER_HEAD,    A_BEGIN,                     0,             0 },
+    { S_START,              CC_PLUS,       S_START,              A_BEGIN | A_EMIT,            CAT_OPERATOR,  O_PLUS },
+    { S_START,              CC_MINUS,      S_START,              A_BEGIN | A_EMIT,            CAT_OPERATOR,  O_MINUS },
+    { S_START,              CC_STAR,       S_START,              A_BEGIN | A_EMIT,            CAT_OPERATOR,  O_MULTIPLY },
+    { S_START,              CC_CARET,      S_START,              A_BEGIN | A_EMIT,            CAT_OPERATOR,  O_POW },
+    { S_START,              CC_PERCENT,    S_START,              A_BEGIN | A_EMIT,            CAT_OPERATOR,  O_MODULO },
+    { S_START,              CC_SEMICOLON,  S_START,              A_BEGIN | A_EMIT,            CAT_DELIMITER, D_SEMICOLON },
+    { S_START,              CC_LBRACE,     S_START,              A_BEGIN | A_EMIT,            CAT_DELIMITER, D_LBRACE },
+    { S_START,              CC_RBRACE,     S_START,              A_BEGIN | A_EMIT,            CAT_DELIMITER, D_RBRACE },
+    { S_START,              CC_LPAREN,     S_START,              A_BEGIN | A_EMIT,            CAT_DELIMITER, D_LPAREN },
+    { S_START,              CC_RPAREN,     S_START,              A_BEGIN | A_EMIT,            CAT_DELIMITER, D_RPAREN },
+    { S_START,              CC_LBRACKET,   S_START,              A_BEGIN | A_EMIT,            CAT_DELIMITER, D_LBRACKET },
+    { S_START,              CC_RBRACKET,   S_START,              A_BEGIN | A_EMIT,            CAT_DELIMITER, D_RBRACKET },
+    { S_START,              CC_COMMA,      S_START,              A_BEGIN | A_EMIT,            CAT_DELIMITER, D_COMMA },
+    { S_START,              CC_DOT,        S_START,              A_BEGIN | A_EMIT,            CAT_DELIMITER, D_DOT },
+
+    //identifiers, decided against the word table when they end
+    { S_IDENTIFIER,         CC_ANY,        S_START,              A_BACK | A_EMIT | A_LOOKUP,  CAT_LITERAL,   L_IDENTIFIER },
+    { S_IDENTIFIER,         CC_ALPHA,      S_IDENTIFIER,         0,                           0,             0 },
+    { S_IDENTIFIER,         CC_DIGIT,      S_IDENTIFIER,         0,                           0,             0 },
+    { S_IDENTIFIER,         CC_UNDERSCORE, S_IDENTIFIER,         0,                           0,             0 },
+
+    //numbers (bilang & lutang), 123invalid and 123. are unknown
+    { S_NUMBER_BILANG,      CC_ANY,        S_START,              A_BACK | A_EMIT,             CAT_LITERAL,   L_BILANG_LITERAL },
+    { S_NUMBER_BILANG,      CC_DIGIT,      S_NUMBER_BILANG,      0,                           0,             0 },
+    { S_NUMBER_BILANG,      CC_DOT,        S_NUMBER_POINT,       0,                           0,             0 },
+    { S_NUMBER_BILANG,      CC_ALPHA,      S_UNKNOWN,            0,                           0,             0 },
+    { S_NUMBER_POINT,       CC_ANY,        S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_NUMBER_POINT,       CC_DIGIT,      S_NUMBER_LUTANG,      0,                           0,             0 },
+    { S_NUMBER_LUTANG,      CC_ANY,        S_START,              A_BACK | A_EMIT,             CAT_LITERAL,   L_LUTANG_LITERAL },
+    { S_NUMBER_LUTANG,      CC_DIGIT,      S_NUMBER_LUTANG,      0,                           0,             0 },
+
+    //kwerdas, a lone " at end of line is a delimiter, an open string is unknown
+    { S_KWERDAS_HEAD,       CC_ANY,        S_KWERDAS_BODY,       0,                           0,             0 },
+    { S_KWERDAS_HEAD,       CC_DQUOTE,     S_START,              A_EMIT,                      CAT_LITERAL,   L_KWERDAS_LITERAL },
+    { S_KWERDAS_HEAD,       CC_NEWLINE,    S_START,              A_BACK | A_LINE | A_EMIT,    CAT_DELIMITER, D_QUOTE },
+    { S_KWERDAS_HEAD,       CC_EOF,        S_START,              A_BACK | A_EMIT,             CAT_DELIMITER, D_QUOTE },
+    { S_KWERDAS_BODY,       CC_ANY,        S_KWERDAS_BODY,       0,                           0,             0 },
+    { S_KWERDAS_BODY,       CC_DQUOTE,     S_START,              A_EMIT,                      CAT_LITERAL,   L_KWERDAS_LITERAL },
+    { S_KWERDAS_BODY,       CC_NEWLINE,    S_START,              A_BACK | A_LINE | A_EMIT,    CAT_UNKNOWN,   U_UNKNOWN },
+    { S_KWERDAS_BODY,       CC_EOF,        S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+
+    //titik, exactly one character between single quotes
+    { S_TITIK_HEAD,         CC_ANY,        S_TITIK_BODY,         0,                           0,             0 },
+    { S_TITIK_HEAD,         CC_SQUOTE,     S_START,              A_BACK | A_EMIT,             CAT_DELIMITER, D_SQUOTE },
+    { S_TITIK_HEAD,         CC_NEWLINE,    S_START,              A_BACK | A_LINE | A_EMIT,    CAT_DELIMITER, D_SQUOTE },
+    { S_TITIK_HEAD,         CC_EOF,        S_START,              A_BACK | A_EMIT,             CAT_DELIMITER, D_SQUOTE },
+    { S_TITIK_BODY,         CC_ANY,        S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_TITIK_BODY,         CC_SQUOTE,     S_START,              A_EMIT,                      CAT_LITERAL,   L_TITIK_LITERAL },
+
+    // / is divide unless a comment starts
+    { S_OP_DIVIDE_HEAD,     CC_ANY,        S_START,              A_BACK | A_EMIT,             CAT_OPERATOR,  O_DIVIDE },
+    { S_OP_DIVIDE_HEAD,     CC_SLASH,      S_COMMENT_SINGLE,     0,                           0,             0 },
+    { S_OP_DIVIDE_HEAD,     CC_STAR,       S_COMMENT_MULTI_HEAD, 0,                           0,             0 },
+
+    //comments
+    { S_COMMENT_SINGLE,     CC_ANY,        S_COMMENT_SINGLE,     0,                           0,             0 },
+    { S_COMMENT_SINGLE,     CC_NEWLINE,    S_START,              A_BACK | A_EMIT,             CAT_COMMENT,   C_SINGLE_LINE },
+    { S_COMMENT_SINGLE,     CC_EOF,        S_START,              A_BACK | A_EMIT,             CAT_COMMENT,   C_SINGLE_LINE },
+    { S_COMMENT_MULTI_HEAD, CC_ANY,        S_COMMENT_MULTI_HEAD, 0,                           0,             0 },
+    { S_COMMENT_MULTI_HEAD, CC_NEWLINE,    S_COMMENT_MULTI_HEAD, A_LINE,                      0,             0 },
+    { S_COMMENT_MULTI_HEAD, CC_STAR,       S_COMMENT_MULTI_TAIL, 0,                           0,             0 },
+    { S_COMMENT_MULTI_HEAD, CC_EOF,        S_START,              A_EMIT,                      CAT_UNKNOWN,   U_UNKNOWN },
+    { S_COMMENT_MULTI_TAIL, CC_ANY,        S_COMMENT_MULTI_HEAD, 0,                           0,             0 },
+    { S_COMMENT_MULTI_TAIL, CC_NEWLINE,    S_COMMENT_MULTI_HEAD, A_LINE,                      0,             0 },
+    { S_COMMENT_MULTI_TAIL, CC_STAR,       S_COMMENT_MULTI_TAIL, 0,                           0,             0 },
+    { S_COMMENT_MULTI_TAIL, CC_SLASH,      S_START,              A_EMIT,                      CAT_COMMENT,   C_MULTI_LINE },
+    { S_COMMENT_MULTI_TAIL, CC_EOF,        S_START,              A_EMIT,                      CAT_UNKNOWN,   U_UNKNOWN },
+
+    //two character operators, a single & or | is unknown
+    { S_OP_AND_HEAD,        CC_ANY,        S_UNKNOWN,            A_BACK,                      0,             0 },
+    { S_OP_AND_HEAD,        CC_AMP,        S_START,              A_EMIT,                      CAT_OPERATOR,  O_AND },
+    { S_OP_OR_HEAD,         CC_ANY,        S_UNKNOWN,            A_BACK,                      0,             0 },
+    { S_OP_OR_HEAD,         CC_PIPE,       S_START,              A_EMIT,                      CAT_OPERATOR,  O_OR },
+    { S_OP_ASSIGN_HEAD,     CC_ANY,        S_START,              A_BACK | A_EMIT,             CAT_OPERATOR,  O_ASSIGN },
+    { S_OP_ASSIGN_HEAD,     CC_EQUAL,      S_START,              A_EMIT,                      CAT_OPERATOR,  O_EQUAL },
+    { S_OP_NOT_HEAD,        CC_ANY,        S_START,              A_BACK | A_EMIT,             CAT_OPERATOR,  O_NOT },
+    { S_OP_NOT_HEAD,        CC_EQUAL,      S_START,              A_EMIT,                      CAT_OPERATOR,  O_NOT_EQUAL },
+    { S_OP_LESS_HEAD,       CC_ANY,        S_START,              A_BACK | A_EMIT,             CAT_OPERATOR,  O_LESS },
+    { S_OP_LESS_HEAD,       CC_EQUAL,      S_START,              A_EMIT,                      CAT_OPERATOR,  O_LESS_EQ },
+    { S_OP_GREATER_HEAD,    CC_ANY,        S_START,              A_BACK | A_EMIT,             CAT_OPERATOR,  O_GREATER },
+    { S_OP_GREATER_HEAD,    CC_EQUAL,      S_START,              A_EMIT,                      CAT_OPERATOR,  O_GREATER_EQ },
+
+    //invalid characters run until whitespace or an operator/delimiter char
+    { S_UNKNOWN,            CC_ANY,        S_UNKNOWN,            0,                           0,             0 },
+    { S_UNKNOWN,            CC_SPACE,      S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_NEWLINE,    S_START,              A_BACK | A_LINE | A_EMIT,    CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_EOF,        S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_NUL,        S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_PLUS,       S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_MINUS,      S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_STAR,       S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_SLASH,      S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_CARET,      S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_PERCENT,    S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_AMP,        S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_PIPE,       S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_EQUAL,      S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_BANG,       S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_LESS,       S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_GREATER,    S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_LPAREN,     S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_RPAREN,     S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_LBRACE,     S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_RBRACE,     S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_LBRACKET,   S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_RBRACKET,   S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_COMMA,      S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_DOT,        S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+    { S_UNKNOWN,            CC_SEMICOLON,  S_START,              A_BACK | A_EMIT,             CAT_UNKNOWN,   U_UNKNOWN },
+};
+
+static unsigned char charClass[256];
+static LexTransition lexTable[LEXER_STATES][CHAR_CLASSES];
+
+//fill charClass[] and expand lexRules[] into the dense lexTable[][]
+static void initialize_lexer_table(void) {
+    for (int c = 0; c < 256; c++) {
+        if (isalpha(c)) charClass[c] = CC_ALPHA;
+        else if (isdigit(c)) charClass[c] = CC_DIGIT;
+        else if (c == '\n') charClass[c] = CC_NEWLINE;
+        else if (isspace(c)) charClass[c] = CC_SPACE;
+        else charClass[c] = CC_OTHER;
+    }
+    charClass['\0'] = CC_NUL;
+    charClass['_'] = CC_UNDERSCORE;
+    charClass['"'] = CC_DQUOTE;
+    charClass['\''] = CC_SQUOTE;
+    charClass['/'] = CC_SLASH;
+    charClass['*'] = CC_STAR;
+    charClass['&'] = CC_AMP;
+    charClass['|'] = CC_PIPE;
+    charClass['='] = CC_EQUAL;
+    charClass['!'] = CC_BANG;
+    charClass['<'] = CC_LESS;
+    charClass['>'] = CC_GREATER;
+    charClass['+'] = CC_PLUS;
+    charClass['-'] = CC_MINUS;
+    charClass['^'] = CC_CARET;
+    charClass['%'] = CC_PERCENT;
+    charClass['.'] = CC_DOT;
+    charClass[';'] = CC_SEMICOLON;
+    charClass['{'] = CC_LBRACE;
+    charClass['}'] = CC_RBRACE;
+    charClass['('] = CC_LPAREN;
+    charClass[')'] = CC_RPAREN;
+    charClass['['] = CC_LBRACKET;
+    charClass[']'] = CC_RBRACKET;
+    charClass[','] = CC_COMMA;
+
+    //a state's CC_ANY row comes first, the specific rows then overwrite it
+    for (size_t i = 0; i < sizeof(lexRules) / sizeof(lexRules[0]); i++) {
+        const LexRule *r = &lexRules[i];
+        LexTransition t = { (unsigned char)r->to, r->action, (unsigned char)r->category, (unsigned char)r->tokenValue };
+        if (r->on == CC_ANY) {
+            for (int cls = 0; cls < CHAR_CLASSES; cls++)
+                lexTable[r->from][cls] = t;
+        } else {
+            lexTable[r->from][r->on] = t;
+        }
+    }
+}
+
+void initialize_lexer(void) {
+    static bool ready = false;
+    if (ready)
+        return;
+    initialize_lexer_table();
+    scanInit();
+    ready = true;
+}
+
+void lexer_init(LexerCtx *ctx, const char *source, size_t length) {
+    if (length > TOKEN_SOURCE_MAX) { //sourceLoad() refuses these, other buffers land here
+        fprintf(stderr, "Error: source is %zu bytes, at most %lu can be lexed\n",
+                length, (unsigned long)TOKEN_SOURCE_MAX);
+        exit(1);
+    }
+    ctx->base = (const unsigned char *)source;
+    ctx->cur = ctx->base;
+    ctx->end = ctx->base + length;
+    ctx->lineNumber = 1;
+    ctx->state = S_START;
+    ctx->tokenStart = ctx->base;
+    ctx->tokenStartLine = 1;
+    ctx->more = 0;
+}
+
+// Runs the DFA from where the last call stopped until a token is emitted
+int lexer_next(LexerCtx *ctx, TokenSpan *tok) {
+    const unsigned char *cur = ctx->cur; //next unread char
+    const unsigned char *end = ctx->end;
+    const unsigned char *tokenStart = ctx->tokenStart; //first char of the current lexeme
+    LexerState currentState = ctx->state;
+    int lineNumber = ctx->lineNumber;
+    int tokenStartLine = ctx->tokenStartLine;
+    
+    int c; // Current character
+    int cls; // its character class
+
+    //reads/checks 1 character per iteration, the table says what to do with it
+    while (true) {
+        //runs the table would only skip byte by byte are consumed
+        //in bulk by the scan kernels (lines inside are counted)
+        if (cur < end) {
+            switch (currentState) {
+                case S_START:
+                    cur += scanSpaces(cur, end, &lineNumber);
+                    break;
+                case S_IDENTIFIER:
+                    cur += scanIdentifier(cur, end);
+                    break;
+                case S_KWERDAS_BODY:
+                    cur += scanUntil2(cur, end, '"', '\n');
+                    break;
+                case S_COMMENT_SINGLE:
+                    cur += scanUntil2(cur, end, '\n', '\n');
+                    break;
+                case S_COMMENT_MULTI_HEAD:
+                    cur += scanUntilCountLines(cur, end, '*', &lineNumber);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (cur < end) {
+            c = *cur++;
+            cls = charClass[c];
+        } else if (ctx->more) {
+            //out of input for now, keep the lexeme in progress for the next call
+            ctx->cur = cur;
+            ctx->lineNumber = lineNumber;
+            ctx->state = currentState;
+            ctx->tokenStart = tokenStart;
+            ctx->tokenStartLine = tokenStartLine;
+            return 0;
+        } else {
+            c = EOF;
+            cls = CC_EOF;
+        }
+
+        const LexTransition *t = &lexTable[currentState][cls];
+        unsigned action = t->action;
+
+        if (action & A_BEGIN) {
+            tokenStart = cur - 1;
+            tokenStartLine = lineNumber;
+        }
+        if ((action & A_BACK) && c != EOF) {
+            cur--; //char belongs to the next lexeme
+        }
+        if (action & A_LINE) {
+            lineNumber++;
+        }
+        if (action & A_STOP) {
+            ctx->cur = cur;
+            ctx->lineNumber = lineNumber;
+            ctx->state = S_START;
+            return 0; //eof, nothing left
+        }
+        currentState = (LexerState)t->next;
+        if (action & A_EMIT) {
+            //lexeme is everything consumed since A_BEGIN
+            tok->offset = (uint32_t)(tokenStart - ctx->base);
+            tok->length = (uint32_t)(cur - tokenStart);
+            tok->lineNumber = (uint32_t)tokenStartLine;
+            tok->category = t->category;
+            tok->tokenValue = t->tokenValue;
+            if (action & A_LOOKUP) {
+                const HashEntry *entry = wordLookup((const char *)tokenStart, tok->length);
+                if (entry) {
+                    tok->category = (uint8_t)entry->category;
+                    tok->tokenValue = (uint8_t)entry->tokenValue;
+                }
+            }
+            ctx->cur = cur;
+            ctx->lineNumber = lineNumber;
+            ctx->state = currentState;
+            ctx->tokenStart = tokenStart;
+            ctx->tokenStartLine = tokenStartLine;
+            return 1;
+        }
+    } //end while
+}
+
+void tokenListPush(TokenList *list, const TokenSpan *tok) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 4096;
+        TokenSpan *grown = realloc(list->tokens, capacity * sizeof(TokenSpan));
+        if (!grown) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        list->tokens = grown;
+        list->capacity = capacity;
+    }
+    list->tokens[list->count++] = *tok;
+}
+
+void tokenListFree(TokenList *list) {
+    free(list->tokens);
+    list->tokens = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+//create a Token with its own copy of the lexeme, owned by the arena
+//(for code that keeps tokens after the source buffer is released)
+Token makeToken(Arena *lexemes, const TokenSpan *span, const char *source) {
+    Token t;
+    t.category = (TokenCategory)span->category;
+    t.tokenValue = span->tokenValue;
+    t.lexeme = arenaStrndup(lexemes, source + span->offset, span->length);
+    t.lineNumber = (int)span->lineNumber;
+    return t;
+}
@@ -1,8 +1,107 @@
 #ifndef LEXER_H
 #define LEXER_H
 
-// Expose the hash table functions
-void initialize_table(void);
+#include <stddef.h>
+#include "tokens.h"
+#include "arena.h"
+
+//States
+typedef enum {
+    S_START,   //Start state
+
+    //Words without quotes(" ")
+    S_IDENTIFIER,       
+    S_KEYWORD,  // Note: These are final states, decided *after* S_IDENTIFIER
+    S_RESERVE,  // Note: These are final states, decided *after* S_IDENTIFIER
+    S_NOISE,    // Note: These are final states, decided *after* S_IDENTIFIER
+
+    //Numbers
+    S_NUMBER_BILANG,
+    S_NUMBER_POINT,    // 123. (a digit must follow the point)
+    S_NUMBER_LUTANG,
+
+    //Strings & characters
+    S_KWERDAS_HEAD,   //for double quote start
+    S_KWERDAS_BODY,    //main string
+    S_KWERDAS_TAIL,    //last double quote
+
+    //Strings & characters
+    S_TITIK_HEAD,   //for single quote start
+    S_TITIK_BODY,    //main charatcer 
+    S_TITIK_TAIL,    //last single quote
+
+    // Operators
+    S_OP_PLUS,
+    S_OP_MINUS,        
+    S_OP_MULTIPLY,
+    S_OP_POW,
+    S_OP_MOD,      
+    S_OP_DIVIDE_HEAD,      // /  (may lead to comments)
+    S_OP_ASSIGN_HEAD,      // =
+    S_OP_ASSIGN_TAIL,  // == (Final State)
+    S_OP_NOT_HEAD,         // !
+    S_OP_NOT_TAIL,     // != or ! (Final State)
+    S_OP_LESS_HEAD,        // <
+    S_OP_LESS_TAIL,    // <= or < (Final State)
+    S_OP_GREATER_HEAD,     // >
+    S_OP_GREATER_TAIL, // >= or > (Final State)
+    S_OP_AND_HEAD,     //&
+    S_OP_AND_TAIL,     // && (Final State)
+    S_OP_OR_HEAD,      // |  
+    S_OP_OR_TAIL,      // || (Final State)
+
+    //Comments
+    S_COMMENT_SINGLE,  // //
+    S_COMMENT_MULTI_HEAD,   // /*
+    S_COMMENT_MULTI_TAIL, // checking for */
+
+    // Delimiters
+    S_DELIMITER,       // ( ) { } [ ] , . ; etc. (Final State)
+
+    // End / Unknown
+    S_UNKNOWN,
+    S_DONE // (Unused in this implementation)
+} LexerState;
+
+//Pull-style lexer over an in-memory source: each lexer_next() call runs the
+//state machine until one token is complete and hands it back.
+typedef struct {
+    const unsigned char *base;  // first byte of the source
+    const unsigned char *cur;   // next unread byte
+    const unsigned char *end;   // one past the last byte
+    int lineNumber;             // line cur is on
+    LexerState state;           // state to resume in (S_START between tokens)
+    const unsigned char *tokenStart;  // lexeme in progress when state != S_START
+    int tokenStartLine;
+    int more;                   // more input follows end: stop there without
+                                // ending the lexeme in progress (see lexer_next)
+} LexerCtx;
+
+//DFA tables and scan kernels, safe to call more than once
+void initialize_lexer(void);
+
+void lexer_init(LexerCtx *ctx, const char *source, size_t length);
+
+//next token (comments included), returns 0 once the input is used up.
+//With ctx->more set, reaching end is not end of input: 0 is returned with
+//state/tokenStart/tokenStartLine holding the unfinished lexeme, and lexing
+//can carry on once cur/end are moved over the input that follows.
+int lexer_next(LexerCtx *ctx, TokenSpan *tok);
+
+//growable array of spans, in source order
+typedef struct {
+    TokenSpan *tokens;
+    size_t count;
+    size_t capacity;
+} TokenList;
+
+void tokenListPush(TokenList *list, const TokenSpan *tok);
+void tokenListFree(TokenList *list);
+
+//Token with its own copy of the lexeme, owned by the arena
+Token makeToken(Arena *lexemes, const TokenSpan *span, const char *source);
+
+// Expose the word lookup for the parser
 int hashLookup(const char *lexeme, int *category, int *value);
 
-#endif
\ No newline at end of file
+#endif
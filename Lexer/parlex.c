@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "parlex.h"
+
+typedef struct {
+    const char *source;
+    size_t length;
+    size_t begin, finish;   // chunk is source[begin, finish)
+    TokenList tokens;       // lexed from S_START, lines counted from 0
+    LexerCtx end;           // where lexing the chunk stopped
+} Chunk;
+
+//lexer over source[begin, finish), more input follows unless it is the last chunk
+static void chunkContext(LexerCtx *ctx, const Chunk *chunk) {
+    lexer_init(ctx, chunk->source, chunk->length);
+    ctx->cur = ctx->base + chunk->begin;
+    ctx->end = ctx->base + chunk->finish;
+    ctx->more = chunk->finish < chunk->length;
+}
+
+//speculative pass: assume nothing is carried over from the chunk before
+static void *lexChunk(void *arg) {
+    Chunk *chunk = arg;
+    LexerCtx ctx;
+    TokenSpan tok;
+
+    chunkContext(&ctx, chunk);
+    ctx.lineNumber = chunk->begin == 0 ? 1 : 0;
+    ctx.tokenStartLine = ctx.lineNumber;
+    while (lexer_next(&ctx, &tok))
+        tokenListPush(&chunk->tokens, &tok);
+    chunk->end = ctx;
+    return NULL;
+}
+
+//cut points just after a newline, about length / count apart
+static int splitChunks(const char *source, size_t length, int count, Chunk *chunks) {
+    size_t begin = 0;
+    int made = 0;
+
+    for (int i = 1; i <= count && begin < length; i++) {
+        size_t finish = length;
+        if (i < count) {
+            size_t target = (size_t)((unsigned long long)length * i / count);
+            const char *newline;
+            if (target < begin)
+                target = begin;
+            newline = memchr(source + target, '\n', length - target);
+            finish = newline ? (size_t)(newline - source) + 1 : length;
+        }
+        chunks[made].source = source;
+        chunks[made].length = length;
+        chunks[made].begin = begin;
+        chunks[made].finish = finish;
+        memset(&chunks[made].tokens, 0, sizeof(TokenList));
+        made++;
+        begin = finish;
+    }
+    return made;
+}
+
+int lexParallel(const char *source, size_t length, int threads, TokenList *out) {
+    Chunk chunks[PARLEX_MAX_THREADS];
+    pthread_t workers[PARLEX_MAX_THREADS];
+    int started[PARLEX_MAX_THREADS] = {0};
+    int count;
+
+    if (threads < 1)
+        threads = 1;
+    if (threads > PARLEX_MAX_THREADS)
+        threads = PARLEX_MAX_THREADS;
+    memset(out, 0, sizeof(*out));
+    count = splitChunks(source, length, threads, chunks);
+
+    //chunk 0 runs on this thread
+    for (int i = 1; i < count; i++)
+        started[i] = pthread_create(&workers[i], NULL, lexChunk, &chunks[i]) == 0;
+    if (count > 0)
+        lexChunk(&chunks[0]);
+    for (int i = 1; i < count; i++) {
+        if (started[i])
+            pthread_join(workers[i], NULL);
+        else
+            lexChunk(&chunks[i]); //no thread to spare, do it here
+    }
+
+    //chunk 0 is always right, its list becomes the output; the rest are
+    //appended with room made for every speculative token up front
+    size_t total = 0;
+    for (int i = 0; i < count; i++)
+        total += chunks[i].tokens.count;
+    if (count > 0) {
+        *out = chunks[0].tokens;
+        memset(&chunks[0].tokens, 0, sizeof(TokenList));
+        if (total > out->capacity) {
+            TokenSpan *grown = realloc(out->tokens, total * sizeof(TokenSpan));
+            if (!grown) {
+                fprintf(stderr, "Error: out of memory\n");
+                exit(1);
+            }
+            out->tokens = grown;
+            out->capacity = total;
+        }
+    }
+
+    //stitch in order; carry is where the real (sequential) lexer would be
+    LexerCtx carry = count > 0 ? chunks[0].end : (LexerCtx){0};
+    for (int i = 1; i < count; i++) {
+        Chunk *chunk = &chunks[i];
+        if (carry.state == S_START) {
+            //the guess held: keep the tokens, shift them to the right lines
+            int lineBase = carry.lineNumber;
+            size_t first = out->count;
+            if (out->count + chunk->tokens.count > out->capacity) {
+                //an earlier relex came out longer than guessed
+                for (size_t t = 0; t < chunk->tokens.count; t++)
+                    tokenListPush(out, &chunk->tokens.tokens[t]);
+            } else {
+                memcpy(out->tokens + first, chunk->tokens.tokens, chunk->tokens.count * sizeof(TokenSpan));
+                out->count += chunk->tokens.count;
+            }
+            for (size_t t = first; t < out->count; t++)
+                out->tokens[t].lineNumber += (uint32_t)lineBase;
+            carry = chunk->end;
+            carry.lineNumber += lineBase;
+            carry.tokenStartLine += lineBase;
+        } else {
+            //a lexeme runs into this chunk, lex it again from there
+            TokenSpan tok;
+            carry.end = carry.base + chunk->finish;
+            carry.more = chunk->finish < chunk->length;
+            while (lexer_next(&carry, &tok))
+                tokenListPush(out, &tok);
+        }
+        tokenListFree(&chunk->tokens);
+    }
+    return 0;
+}
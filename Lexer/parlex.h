@@ -0,0 +1,20 @@
+#ifndef PARLEX_H
+#define PARLEX_H
+
+#include <stddef.h>
+#include "lexer.h"
+
+//Lexing one big source on several threads. The source is cut into chunks
+//at line starts and every chunk is lexed on its own thread as if it began
+//in S_START. Stitching the chunks back together checks that guess against
+//where the previous chunk really stopped: when a multi-line comment runs
+//over the cut, that chunk is lexed again from the carried-over state.
+//Line numbers are shifted by the lines counted in the chunks before.
+
+#define PARLEX_MAX_THREADS 64
+
+//every token of source in order, the same spans lexer_next() would give;
+//initialize_lexer() must have run. Returns 0 on success
+int lexParallel(const char *source, size_t length, int threads, TokenList *out);
+
+#endif
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "relex.h"
+
+//first token that ends at or after offset (its end was decided by a
+//lookahead at or past the edit), count if there is none
+static size_t firstTouched(const TokenList *tokens, size_t offset) {
+    size_t low = 0, high = tokens->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        const TokenSpan *t = &tokens->tokens[mid];
+        if ((size_t)t->offset + t->length < offset)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+RelexResult relex(TokenList *tokens, const char *source, size_t length, const RelexEdit *edit) {
+    RelexResult result;
+    TokenList fresh = { NULL, 0, 0 };
+    LexerCtx ctx;
+    TokenSpan tok;
+    long long delta = (long long)edit->inserted - (long long)edit->removed;
+    size_t oldEditEnd = edit->offset + edit->removed;
+    size_t newEditEnd = edit->offset + edit->inserted;
+    long long lineDelta = 0;
+
+    //resume at the token before the first touched one: it ended before the
+    //edit, so it and everything in front of it are still right
+    size_t touched = firstTouched(tokens, edit->offset);
+    size_t first = touched > 0 ? touched - 1 : 0;
+    lexer_init(&ctx, source, length);
+    if (first < tokens->count && touched > 0) {
+        ctx.cur = ctx.base + tokens->tokens[first].offset;
+        ctx.lineNumber = (int)tokens->tokens[first].lineNumber;
+        ctx.tokenStart = ctx.cur;
+        ctx.tokenStartLine = ctx.lineNumber;
+    } else {
+        first = 0;
+    }
+    const unsigned char *resumedAt = ctx.cur;
+
+    //old token to try to line up with next
+    size_t old = touched;
+    int synced = 0;
+    while (lexer_next(&ctx, &tok)) {
+        if (tok.offset >= newEditEnd) {
+            while (old < tokens->count
+                   && (tokens->tokens[old].offset < oldEditEnd
+                       || (long long)tokens->tokens[old].offset + delta < (long long)tok.offset))
+                old++;
+            if (old < tokens->count && (long long)tokens->tokens[old].offset + delta == (long long)tok.offset) {
+                //both lexers start a token here in S_START over the same text
+                lineDelta = (long long)tok.lineNumber - (long long)tokens->tokens[old].lineNumber;
+                synced = 1;
+                break;
+            }
+        }
+        tokenListPush(&fresh, &tok);
+    }
+    if (!synced)
+        old = tokens->count;
+
+    result.first = first;
+    result.oldCount = old - first;
+    result.newCount = fresh.count;
+    result.lexedBytes = (size_t)((synced ? ctx.base + tok.offset : ctx.cur) - resumedAt);
+
+    //splice: [first, old) becomes fresh, the tail moves by delta / lineDelta
+    size_t tail = tokens->count - old;
+    result.shiftedTokens = tail;
+    size_t count = first + fresh.count + tail;
+    if (count > tokens->capacity) {
+        TokenSpan *grown = realloc(tokens->tokens, count * sizeof(TokenSpan));
+        if (!grown) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        tokens->tokens = grown;
+        tokens->capacity = count;
+    }
+    memmove(tokens->tokens + first + fresh.count, tokens->tokens + old, tail * sizeof(TokenSpan));
+    if (fresh.count)
+        memcpy(tokens->tokens + first, fresh.tokens, fresh.count * sizeof(TokenSpan));
+    tokens->count = count;
+    if (delta != 0 || lineDelta != 0) {
+        for (size_t i = first + fresh.count; i < count; i++) {
+            tokens->tokens[i].offset = (uint32_t)((long long)tokens->tokens[i].offset + delta);
+            tokens->tokens[i].lineNumber = (uint32_t)((long long)tokens->tokens[i].lineNumber + lineDelta);
+        }
+    }
+    tokenListFree(&fresh);
+    return result;
+}
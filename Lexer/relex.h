@@ -0,0 +1,41 @@
+#ifndef RELEX_H
+#define RELEX_H
+
+#include <stddef.h>
+#include "lexer.h"
+
+//Incremental re-lexing after an edit, for editor-style use where one
+//keystroke should not mean lexing the whole file again.
+//
+//Every token starts with the lexer in S_START, so lexing can resume at the
+//start of any token that the edit cannot have touched, with that token's
+//line. New tokens are made from there until one starts, past the edit, at
+//the same (shifted) place as an old token: from that point on both streams
+//see the same text in the same state, so the rest of the old stream is
+//kept, with offsets and lines moved by the edit.
+//
+//Lexing is proportional to the edit, but the list is one flat array with
+//absolute offsets: the kept tail is moved and every token in it shifted,
+//a pass over the tokens after the edit. That pass is a memmove and one
+//add per token, far cheaper than lexing them, but it does grow with the
+//file; shiftedTokens reports it.
+
+typedef struct {
+    size_t offset;     // where the edit starts (same in old and new text)
+    size_t removed;    // bytes of old text taken out at offset
+    size_t inserted;   // bytes of new text put in at offset
+} RelexEdit;
+
+typedef struct {
+    size_t first;         // index of the first token that was replaced
+    size_t oldCount;      // tokens replaced from the old stream
+    size_t newCount;      // tokens put in their place
+    size_t lexedBytes;    // bytes of source the lexer went over
+    size_t shiftedTokens; // tokens after the replaced ones, moved to their new place
+} RelexResult;
+
+//update tokens (the full stream of the text before the edit) for source,
+//the text after it; initialize_lexer() must have run
+RelexResult relex(TokenList *tokens, const char *source, size_t length, const RelexEdit *edit);
+
+#endif
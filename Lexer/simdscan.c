@@ -0,0 +1,296 @@
+#include <stddef.h>
+#include "simdscan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// ---- Scalar versions (any CPU, and the tail of every vector loop) ----
+
+static int isSpaceByte(unsigned char c) {
+    return c == ' ' || (unsigned char)(c - '\t') <= 4; // \t \n \v \f \r
+}
+
+static int isIdentByte(unsigned char c) {
+    return (unsigned char)((c | 0x20) - 'a') < 26 || (unsigned char)(c - '0') < 10 || c == '_';
+}
+
+static size_t spacesScalar(const unsigned char *p, const unsigned char *end, int *newlines) {
+    const unsigned char *start = p;
+    while (p < end && isSpaceByte(*p)) {
+        if (*p == '\n')
+            (*newlines)++;
+        p++;
+    }
+    return (size_t)(p - start);
+}
+
+static size_t identScalar(const unsigned char *p, const unsigned char *end) {
+    const unsigned char *start = p;
+    while (p < end && isIdentByte(*p))
+        p++;
+    return (size_t)(p - start);
+}
+
+static size_t until2Scalar(const unsigned char *p, const unsigned char *end, unsigned char stop, unsigned char stop2) {
+    const unsigned char *start = p;
+    while (p < end && *p != stop && *p != stop2)
+        p++;
+    return (size_t)(p - start);
+}
+
+static size_t untilLinesScalar(const unsigned char *p, const unsigned char *end, unsigned char stop, int *newlines) {
+    const unsigned char *start = p;
+    while (p < end && *p != stop) {
+        if (*p == '\n')
+            (*newlines)++;
+        p++;
+    }
+    return (size_t)(p - start);
+}
+
+#ifdef SCAN_X86
+
+// ---- SSE2: 16 bytes per step ----
+// Range tests use the unsigned min trick: x in [lo, lo+n] <=> min(x-lo, n) == x-lo
+
+__attribute__((target("sse2")))
+static size_t spacesSSE2(const unsigned char *p, const unsigned char *end, int *newlines) {
+    const unsigned char *start = p;
+    const __m128i blank = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i four = _mm_set1_epi8(4);
+    const __m128i lf = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i t = _mm_sub_epi8(v, tab);
+        __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(t, four), t);
+        unsigned space = (unsigned)_mm_movemask_epi8(_mm_or_si128(ctrl, _mm_cmpeq_epi8(v, blank)));
+        unsigned lines = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, lf));
+        if (space != 0xFFFF) {
+            unsigned n = (unsigned)__builtin_ctz(~space);
+            *newlines += __builtin_popcount(lines & ((1u << n) - 1));
+            return (size_t)(p - start) + n;
+        }
+        *newlines += __builtin_popcount(lines);
+        p += 16;
+    }
+    return (size_t)(p - start) + spacesScalar(p, end, newlines);
+}
+
+__attribute__((target("sse2")))
+static size_t identSSE2(const unsigned char *p, const unsigned char *end) {
+    const unsigned char *start = p;
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i lowerA = _mm_set1_epi8('a');
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i under = _mm_set1_epi8('_');
+    const __m128i n25 = _mm_set1_epi8(25);
+    const __m128i n9 = _mm_set1_epi8(9);
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i ta = _mm_sub_epi8(_mm_or_si128(v, caseBit), lowerA);
+        __m128i td = _mm_sub_epi8(v, zero);
+        __m128i alpha = _mm_cmpeq_epi8(_mm_min_epu8(ta, n25), ta);
+        __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(td, n9), td);
+        __m128i ok = _mm_or_si128(_mm_or_si128(alpha, digit), _mm_cmpeq_epi8(v, under));
+        unsigned mask = (unsigned)_mm_movemask_epi8(ok);
+        if (mask != 0xFFFF)
+            return (size_t)(p - start) + (unsigned)__builtin_ctz(~mask);
+        p += 16;
+    }
+    return (size_t)(p - start) + identScalar(p, end);
+}
+
+__attribute__((target("sse2")))
+static size_t until2SSE2(const unsigned char *p, const unsigned char *end, unsigned char stop, unsigned char stop2) {
+    const unsigned char *start = p;
+    const __m128i s1 = _mm_set1_epi8((char)stop);
+    const __m128i s2 = _mm_set1_epi8((char)stop2);
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        unsigned hit = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, s1), _mm_cmpeq_epi8(v, s2)));
+        if (hit)
+            return (size_t)(p - start) + (unsigned)__builtin_ctz(hit);
+        p += 16;
+    }
+    return (size_t)(p - start) + until2Scalar(p, end, stop, stop2);
+}
+
+__attribute__((target("sse2")))
+static size_t untilLinesSSE2(const unsigned char *p, const unsigned char *end, unsigned char stop, int *newlines) {
+    const unsigned char *start = p;
+    const __m128i s = _mm_set1_epi8((char)stop);
+    const __m128i lf = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        unsigned hit = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, s));
+        unsigned lines = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, lf));
+        if (hit) {
+            unsigned n = (unsigned)__builtin_ctz(hit);
+            *newlines += __builtin_popcount(lines & ((1u << n) - 1));
+            return (size_t)(p - start) + n;
+        }
+        *newlines += __builtin_popcount(lines);
+        p += 16;
+    }
+    return (size_t)(p - start) + untilLinesScalar(p, end, stop, newlines);
+}
+
+// ---- AVX2: same kernels, 32 bytes per step ----
+
+__attribute__((target("avx2")))
+static size_t spacesAVX2(const unsigned char *p, const unsigned char *end, int *newlines) {
+    const unsigned char *start = p;
+    const __m256i blank = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i four = _mm256_set1_epi8(4);
+    const __m256i lf = _mm256_set1_epi8('\n');
+
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i t = _mm256_sub_epi8(v, tab);
+        __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(t, four), t);
+        unsigned space = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(ctrl, _mm256_cmpeq_epi8(v, blank)));
+        unsigned lines = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, lf));
+        if (space != 0xFFFFFFFFu) {
+            unsigned n = (unsigned)__builtin_ctz(~space);
+            *newlines += __builtin_popcount(lines & ((1u << n) - 1));
+            return (size_t)(p - start) + n;
+        }
+        *newlines += __builtin_popcount(lines);
+        p += 32;
+    }
+    return (size_t)(p - start) + spacesSSE2(p, end, newlines);
+}
+
+__attribute__((target("avx2")))
+static size_t identAVX2(const unsigned char *p, const unsigned char *end) {
+    const unsigned char *start = p;
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i lowerA = _mm256_set1_epi8('a');
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i under = _mm256_set1_epi8('_');
+    const __m256i n25 = _mm256_set1_epi8(25);
+    const __m256i n9 = _mm256_set1_epi8(9);
+
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i ta = _mm256_sub_epi8(_mm256_or_si256(v, caseBit), lowerA);
+        __m256i td = _mm256_sub_epi8(v, zero);
+        __m256i alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(ta, n25), ta);
+        __m256i digit = _mm256_cmpeq_epi8(_mm256_min_epu8(td, n9), td);
+        __m256i ok = _mm256_or_si256(_mm256_or_si256(alpha, digit), _mm256_cmpeq_epi8(v, under));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(ok);
+        if (mask != 0xFFFFFFFFu)
+            return (size_t)(p - start) + (unsigned)__builtin_ctz(~mask);
+        p += 32;
+    }
+    return (size_t)(p - start) + identSSE2(p, end);
+}
+
+__attribute__((target("avx2")))
+static size_t until2AVX2(const unsigned char *p, const unsigned char *end, unsigned char stop, unsigned char stop2) {
+    const unsigned char *start = p;
+    const __m256i s1 = _mm256_set1_epi8((char)stop);
+    const __m256i s2 = _mm256_set1_epi8((char)stop2);
+
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        unsigned hit = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, s1), _mm256_cmpeq_epi8(v, s2)));
+        if (hit)
+            return (size_t)(p - start) + (unsigned)__builtin_ctz(hit);
+        p += 32;
+    }
+    return (size_t)(p - start) + until2SSE2(p, end, stop, stop2);
+}
+
+__attribute__((target("avx2")))
+static size_t untilLinesAVX2(const unsigned char *p, const unsigned char *end, unsigned char stop, int *newlines) {
+    const unsigned char *start = p;
+    const __m256i s = _mm256_set1_epi8((char)stop);
+    const __m256i lf = _mm256_set1_epi8('\n');
+
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        unsigned hit = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, s));
+        unsigned lines = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, lf));
+        if (hit) {
+            unsigned n = (unsigned)__builtin_ctz(hit);
+            *newlines += __builtin_popcount(lines & ((1u << n) - 1));
+            return (size_t)(p - start) + n;
+        }
+        *newlines += __builtin_popcount(lines);
+        p += 32;
+    }
+    return (size_t)(p - start) + untilLinesSSE2(p, end, stop, newlines);
+}
+
+#endif // SCAN_X86
+
+// ---- Dispatch ----
+
+size_t (*scanSpaces)(const unsigned char *, const unsigned char *, int *) = spacesScalar;
+size_t (*scanIdentifier)(const unsigned char *, const unsigned char *) = identScalar;
+size_t (*scanUntil2)(const unsigned char *, const unsigned char *, unsigned char, unsigned char) = until2Scalar;
+size_t (*scanUntilCountLines)(const unsigned char *, const unsigned char *, unsigned char, int *) = untilLinesScalar;
+
+//best level the CPU (and OS, for the AVX registers) supports
+static ScanLevel detectLevel(void) {
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SCAN_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SCAN_SSE2;
+#endif
+    return SCAN_SCALAR;
+}
+
+ScanLevel scanSetLevel(ScanLevel level) {
+    ScanLevel best = detectLevel();
+    if (level > best)
+        level = best;
+
+    switch (level) {
+#ifdef SCAN_X86
+        case SCAN_AVX2:
+            scanSpaces = spacesAVX2;
+            scanIdentifier = identAVX2;
+            scanUntil2 = until2AVX2;
+            scanUntilCountLines = untilLinesAVX2;
+            break;
+        case SCAN_SSE2:
+            scanSpaces = spacesSSE2;
+            scanIdentifier = identSSE2;
+            scanUntil2 = until2SSE2;
+            scanUntilCountLines = untilLinesSSE2;
+            break;
+#endif
+        default:
+            level = SCAN_SCALAR;
+            scanSpaces = spacesScalar;
+            scanIdentifier = identScalar;
+            scanUntil2 = until2Scalar;
+            scanUntilCountLines = untilLinesScalar;
+            break;
+    }
+    return level;
+}
+
+ScanLevel scanInit(void) {
+    return scanSetLevel(SCAN_AVX2);
+}
+
+const char *scanLevelName(ScanLevel level) {
+    switch (level) {
+        case SCAN_AVX2: return "avx2";
+        case SCAN_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef SIMDSCAN_H
+#define SIMDSCAN_H
+
+#include <stddef.h>
+
+//Kernels that find the end of a run of "boring" bytes (whitespace,
+//identifier characters, string body, comment text) 16 or 32 bytes at a time.
+//Each returns how many bytes from p belong to the run (never past end).
+
+typedef enum {
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2
+} ScanLevel;
+
+//pick the best kernels for this CPU (cpuid), returns the level chosen
+ScanLevel scanInit(void);
+
+//force a level (for benchmarks), clamped to what the CPU supports
+ScanLevel scanSetLevel(ScanLevel level);
+const char *scanLevelName(ScanLevel level);
+
+//blank \t \n \v \f \r, adds the newlines skipped to *newlines
+extern size_t (*scanSpaces)(const unsigned char *p, const unsigned char *end, int *newlines);
+
+//a-z A-Z 0-9 _
+extern size_t (*scanIdentifier)(const unsigned char *p, const unsigned char *end);
+
+//everything up to the first stop or stop2 byte
+extern size_t (*scanUntil2)(const unsigned char *p, const unsigned char *end, unsigned char stop, unsigned char stop2);
+
+//everything up to the first stop byte, adds the newlines skipped to *newlines
+extern size_t (*scanUntilCountLines)(const unsigned char *p, const unsigned char *end, unsigned char stop, int *newlines);
+
+#endif
@@ -0,0 +1,136 @@
+//madvise() is not POSIX, ask the C library for it under -std=c11 too
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "source.h"
+#include "tokens.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define STREAM_CHUNK 65536
+
+//map a regular file read-only, returns 1 if the mapping was made
+static int mapFile(SourceBuffer *src, FILE *file) {
+#ifndef _WIN32
+    struct stat st;
+    int fd = fileno(file);
+
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+        return 0;
+    if (ftell(file) != 0) //someone already read part of it
+        return 0;
+
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED)
+        return 0;
+    madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    src->data = view;
+    src->length = (size_t)st.st_size;
+    src->mapped = 1;
+    return 1;
+#else
+    (void)src;
+    (void)file;
+    return 0;
+#endif
+}
+
+//regular file we cannot map: size is known, so read it with one call
+static int readWhole(SourceBuffer *src, FILE *file) {
+    long start = ftell(file);
+    if (start < 0 || fseek(file, 0, SEEK_END) != 0)
+        return 0;
+    long end = ftell(file);
+    if (end < start || fseek(file, start, SEEK_SET) != 0)
+        return 0;
+
+    size_t size = (size_t)(end - start);
+    char *buf = malloc(size ? size : 1);
+    if (!buf)
+        return 0;
+    //text mode may hand back fewer bytes than the file size (\r\n -> \n)
+    size_t got = fread(buf, 1, size, file);
+    if (got < size && ferror(file)) {
+        free(buf);
+        return 0;
+    }
+    src->data = buf;
+    src->length = got;
+    src->mapped = 0;
+    return 1;
+}
+
+//pipes / stdin: keep reading big chunks into a growing buffer until EOF
+static int readStream(SourceBuffer *src, FILE *file) {
+    size_t cap = STREAM_CHUNK;
+    size_t len = 0;
+    char *buf = malloc(cap);
+    if (!buf)
+        return -1;
+
+    size_t got;
+    while ((got = fread(buf + len, 1, cap - len, file)) > 0) {
+        len += got;
+        if (len == cap) {
+            char *bigger = realloc(buf, cap * 2);
+            if (!bigger) {
+                free(buf);
+                return -1;
+            }
+            buf = bigger;
+            cap *= 2;
+        }
+    }
+    if (ferror(file)) {
+        free(buf);
+        return -1;
+    }
+    src->data = buf;
+    src->length = len;
+    src->mapped = 0;
+    return 0;
+}
+
+//token offsets are 32 bits: refuse what they cannot reach
+static int checkLength(SourceBuffer *src) {
+    if (src->length <= TOKEN_SOURCE_MAX)
+        return 0;
+    fprintf(stderr, "Error: source is %zu bytes, at most %lu can be lexed\n",
+            src->length, (unsigned long)TOKEN_SOURCE_MAX);
+    sourceRelease(src);
+    return -1;
+}
+
+int sourceLoad(SourceBuffer *src, FILE *file) {
+    src->data = NULL;
+    src->length = 0;
+    src->mapped = 0;
+
+    if (mapFile(src, file) || readWhole(src, file))
+        return checkLength(src);
+    clearerr(file);
+    if (readStream(src, file) != 0)
+        return -1;
+    return checkLength(src);
+}
+
+void sourceRelease(SourceBuffer *src) {
+    if (!src->data)
+        return;
+#ifndef _WIN32
+    if (src->mapped)
+        munmap((void *)src->data, src->length);
+    else
+#endif
+        free((void *)src->data);
+    src->data = NULL;
+    src->length = 0;
+    src->mapped = 0;
+}
@@ -0,0 +1,22 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+//Whole source file held in memory so the lexer can walk it with a pointer.
+//Regular files are memory-mapped; pipes and stdin are read through the FILE*.
+typedef struct {
+    const char *data;   // first byte of the source (not NUL terminated)
+    size_t length;      // number of bytes in data
+    int mapped;         // 1 = data is an mmap view, 0 = data is on the heap
+} SourceBuffer;
+
+//load everything readable from an open file, returns 0 on success (sources
+//over TOKEN_SOURCE_MAX bytes are refused: token offsets could not reach them)
+int sourceLoad(SourceBuffer *src, FILE *file);
+
+//release the mapping / heap copy
+void sourceRelease(SourceBuffer *src);
+
+#endif
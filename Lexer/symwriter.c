@@ -0,0 +1,333 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "symwriter.h"
+
+#define NAME_WIDTH 20     // token name column of the text table
+#define LEXEME_WIDTH 15   // lexeme column of the text table
+
+//tokenValue to String
+const char *tokenValueName(int category, int tokenValue) {
+    switch (category) {
+        case CAT_DELIMITER:
+            switch (tokenValue) {
+                case D_LPAREN: return "D_LPAREN";
+                case D_RPAREN: return "D_RPAREN";
+                case D_LBRACE: return "D_LBRACE";
+                case D_RBRACE: return "D_RBRACE";
+                case D_LBRACKET: return "D_LBRACKET";
+                case D_RBRACKET: return "D_RBRACKET";
+                case D_COMMA: return "D_COMMA";
+                case D_SEMICOLON: return "D_SEMICOLON";
+                case D_COLON: return "D_COLON";
+                case D_DOT: return "D_DOT";
+                case D_QUOTE: return "D_QUOTE";
+                case D_SQUOTE: return "D_SQUOTE";
+                default: return "D_UNKNOWN";
+            }
+
+        case CAT_OPERATOR:
+            switch (tokenValue) {
+                case O_PLUS: return "O_PLUS";
+                case O_MINUS: return "O_MINUS";
+                case O_MULTIPLY: return "O_MULTIPLY";
+                case O_DIVIDE: return "O_DIVIDE";
+                case O_POW: return "O_POW";
+                case O_MODULO: return "O_MODULO";
+                case O_ASSIGN: return "O_ASSIGN";
+                case O_EQUAL: return "O_EQUAL";
+                case O_NOT_EQUAL: return "O_NOT_EQUAL";
+                case O_LESS: return "O_LESS";
+                case O_GREATER: return "O_GREATER";
+                case O_LESS_EQ: return "O_LESS_EQ";
+                case O_GREATER_EQ: return "O_GREATER_EQ";
+                case O_AND: return "O_AND";
+                case O_OR: return "O_OR";
+                case O_NOT: return "O_NOT";
+                default: return "O_UNKNOWN";
+            }
+
+        case CAT_LITERAL:
+            switch (tokenValue) {
+                case L_IDENTIFIER: return "L_IDENTIFIER";
+                case L_BILANG_LITERAL: return "L_BILANG_LITERAL";
+                case L_LUTANG_LITERAL: return "L_LUTANG_LITERAL";
+                case L_KWERDAS_LITERAL: return "L_KWERDAS_LITERAL";
+                case L_TITIK_LITERAL: return "L_TITIK_LITERAL";
+                case L_BULYAN_LITERAL: return "L_BULYAN_LITERAL";
+                default: return "L_UNKNOWN";
+            }
+
+         case CAT_KEYWORD:
+            switch (tokenValue) {
+                case K_ANI: return "K_ANI";
+                case K_TANIM: return "K_TANIM";
+                case K_PARA: return "K_PARA";
+                case K_HABANG: return "K_HABANG";
+                case K_KUNG: return "K_KUNG";
+                case K_KUNDI: return "K_KUNDI";
+                case K_KUNDIMAN: return "K_KUNDIMAN";
+                case K_GAWIN: return "K_GAWIN";
+                case K_TIBAG: return "K_TIBAG";
+                case K_TULOY: return "K_TULOY";
+                case K_PANGKAT: return "K_PANGKAT";
+                case K_STATIK: return "K_STATIK";
+                case K_PRIBADO: return "K_PRIBADO";
+                case K_PROTEKTADO: return "K_PROTEKTADO";
+                case K_PUBLIKO: return "K_PUBLIKO";
+                default: return "K_UNKNOWN";
+            };
+
+        case CAT_RESERVED:
+            switch (tokenValue) {
+                case R_TAMA: return "R_TAMA";
+                case R_MALI: return "R_MALI";
+                case R_UGAT: return "R_UGAT";
+                case R_BALIK: return "R_BALIK";
+                case R_BILANG: return "R_BILANG";
+                case R_KWERDAS: return "R_KWERDAS";
+                case R_TITIK: return "R_TITIK";
+                case R_LUTANG: return "R_LUTANG";
+                case R_BULYAN: return "R_BULYAN";
+                case R_DOBLE: return "R_DOBLE";
+                case R_WALA: return "R_WALA";
+                case R_PI: return "R_C_PI";
+                case R_E_NUM: return "R_C_E";
+                case R_Kiss: return "R_C_KISS";
+                case R_SAMPLE_CONST_STRING: return "R_C_SAMPLE_CONST_STRING";
+                default: return "R_UNKNOWN";
+            };
+
+        case CAT_NOISEWORD:
+            switch (tokenValue) {
+                case N_NG: return "N_NG";
+                case N_AY: return "N_AY";
+                case N_BUNGA: return "N_BUNGA";
+                case N_WAKAS: return "N_WAKAS";
+                case N_SA: return "N_SA";
+                case N_ANG: return "N_ANG";
+                case N_MULA: return "N_MULA";
+                case N_ITAKDA: return "N_ITAKDA";
+                default: return "N_UNKNOWN";
+            };
+         case CAT_COMMENT:
+            switch (tokenValue) {
+                case C_SINGLE_LINE: return "C_SINGLE_LINE";
+                case C_MULTI_LINE: return "C_MULTI_LINE";
+                default: return "C_UNKNOWN";
+            }
+        default: 
+            return "UNKNOWN_CATEGORY";
+    }
+}
+
+//every token name, already padded to the text column width
+typedef struct {
+    char text[32];
+    unsigned char length;  // without padding
+    unsigned char padded;  // with padding (the name if it is wider)
+} NameEntry;
+
+static NameEntry nameTable[TOKEN_KINDS];
+static pthread_once_t nameTableOnce = PTHREAD_ONCE_INIT; //writers may open on several threads
+
+static void buildNameTable(void) {
+    for (int kind = 0; kind < TOKEN_KINDS; kind++) {
+        NameEntry *entry = &nameTable[kind];
+        const char *name = tokenValueName(TOKEN_CATEGORY(kind), kind);
+        size_t length = strlen(name);
+        size_t padded = length < NAME_WIDTH ? NAME_WIDTH : length;
+        memset(entry->text, ' ', sizeof(entry->text));
+        memcpy(entry->text, name, length);
+        entry->length = (unsigned char)length;
+        entry->padded = (unsigned char)padded;
+    }
+}
+
+static const NameEntry *nameOf(const TokenSpan *t) {
+    return &nameTable[t->tokenValue];
+}
+
+int symFormatParse(const char *name) {
+    if (strcmp(name, "text") == 0) return SYM_TEXT;
+    if (strcmp(name, "tsv") == 0) return SYM_TSV;
+    if (strcmp(name, "jsonl") == 0) return SYM_JSONL;
+    return -1;
+}
+
+const char *symFormatFileName(SymFormat format) {
+    switch (format) {
+        case SYM_TSV: return "Symbol Table.tsv";
+        case SYM_JSONL: return "Symbol Table.jsonl";
+        default: return "Symbol Table.txt";
+    }
+}
+
+static void flush(SymWriter *writer) {
+    if (writer->used && fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used)
+        writer->failed = 1;
+    writer->used = 0;
+}
+
+//make room for n more bytes (n must be well under SYM_BUFFER)
+static char *reserve(SymWriter *writer, size_t n) {
+    if (writer->used + n > SYM_BUFFER)
+        flush(writer);
+    return writer->buffer + writer->used;
+}
+
+static void putBytes(SymWriter *writer, const char *bytes, size_t n) {
+    if (n > SYM_BUFFER / 2) {
+        //a huge lexeme (long comment) goes out directly
+        flush(writer);
+        if (fwrite(bytes, 1, n, writer->file) != n)
+            writer->failed = 1;
+        return;
+    }
+    memcpy(reserve(writer, n), bytes, n);
+    writer->used += n;
+}
+
+static void putSpaces(SymWriter *writer, size_t n) {
+    memset(reserve(writer, n), ' ', n);
+    writer->used += n;
+}
+
+static void putNumber(SymWriter *writer, unsigned value) {
+    char digits[10];
+    int n = 0;
+    do {
+        digits[sizeof(digits) - 1 - n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    putBytes(writer, digits + sizeof(digits) - n, (size_t)n);
+}
+
+//TSV: tab, newline, carriage return, backslash and NUL become \t \n \r \\ \0
+static void putTsvEscaped(SymWriter *writer, const unsigned char *p, size_t n) {
+    while (n) {
+        size_t chunk = n < 4096 ? n : 4096;
+        char *out = reserve(writer, chunk * 2);
+        char *start = out;
+        for (size_t i = 0; i < chunk; i++) {
+            unsigned char c = p[i];
+            switch (c) {
+                case '\t': *out++ = '\\'; *out++ = 't'; break;
+                case '\n': *out++ = '\\'; *out++ = 'n'; break;
+                case '\r': *out++ = '\\'; *out++ = 'r'; break;
+                case '\\': *out++ = '\\'; *out++ = '\\'; break;
+                case '\0': *out++ = '\\'; *out++ = '0'; break;
+                default: *out++ = (char)c; break;
+            }
+        }
+        writer->used += (size_t)(out - start);
+        p += chunk;
+        n -= chunk;
+    }
+}
+
+//JSON string body: quote, backslash and control characters escaped, other
+//bytes copied as they are
+static void putJsonEscaped(SymWriter *writer, const unsigned char *p, size_t n) {
+    static const char hex[] = "0123456789abcdef";
+    while (n) {
+        size_t chunk = n < 4096 ? n : 4096;
+        char *out = reserve(writer, chunk * 6);
+        char *start = out;
+        for (size_t i = 0; i < chunk; i++) {
+            unsigned char c = p[i];
+            if (c == '"' || c == '\\') {
+                *out++ = '\\';
+                *out++ = (char)c;
+            } else if (c == '\n') {
+                *out++ = '\\'; *out++ = 'n';
+            } else if (c == '\t') {
+                *out++ = '\\'; *out++ = 't';
+            } else if (c == '\r') {
+                *out++ = '\\'; *out++ = 'r';
+            } else if (c < 0x20) {
+                memcpy(out, "\\u00", 4);
+                out[4] = hex[c >> 4];
+                out[5] = hex[c & 15];
+                out += 6;
+            } else {
+                *out++ = (char)c;
+            }
+        }
+        writer->used += (size_t)(out - start);
+        p += chunk;
+        n -= chunk;
+    }
+}
+
+void symWriterOpen(SymWriter *writer, FILE *file, SymFormat format) {
+    pthread_once(&nameTableOnce, buildNameTable);
+    writer->file = file;
+    writer->format = format;
+    writer->used = 0;
+    writer->failed = 0;
+    writer->buffer = malloc(SYM_BUFFER);
+    if (!writer->buffer) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+}
+
+void symWriterHeader(SymWriter *writer) {
+    static const char text[] = "Lexeme           | Token Name\n";
+    static const char tsv[] = "lexeme\ttoken\tline\n";
+    switch (writer->format) {
+        case SYM_TEXT: putBytes(writer, text, sizeof(text) - 1); break;
+        case SYM_TSV: putBytes(writer, tsv, sizeof(tsv) - 1); break;
+        default: break; //JSON Lines has no header
+    }
+}
+
+void symWriterToken(SymWriter *writer, const TokenSpan *t, const char *source) {
+    const NameEntry *name = nameOf(t);
+    const char *lex = source + t->offset;
+    size_t length = t->length;
+
+    switch (writer->format) {
+        case SYM_TEXT: {
+            //same row as "%-15.*s | %-20s | %d \n", the lexeme stops at a NUL like %s did
+            const char *nul = memchr(lex, '\0', length);
+            if (nul)
+                length = (size_t)(nul - lex);
+            putBytes(writer, lex, length);
+            if (length < LEXEME_WIDTH)
+                putSpaces(writer, LEXEME_WIDTH - length);
+            putBytes(writer, " | ", 3);
+            putBytes(writer, name->text, name->padded);
+            putBytes(writer, " | ", 3);
+            putNumber(writer, t->lineNumber);
+            putBytes(writer, " \n", 2);
+            break;
+        }
+        case SYM_TSV:
+            putTsvEscaped(writer, (const unsigned char *)lex, length);
+            putBytes(writer, "\t", 1);
+            putBytes(writer, name->text, name->length);
+            putBytes(writer, "\t", 1);
+            putNumber(writer, t->lineNumber);
+            putBytes(writer, "\n", 1);
+            break;
+        case SYM_JSONL:
+            putBytes(writer, "{\"lexeme\":\"", 11);
+            putJsonEscaped(writer, (const unsigned char *)lex, length);
+            putBytes(writer, "\",\"token\":\"", 11);
+            putBytes(writer, name->text, name->length);
+            putBytes(writer, "\",\"line\":", 9);
+            putNumber(writer, t->lineNumber);
+            putBytes(writer, "}\n", 2);
+            break;
+    }
+}
+
+int symWriterClose(SymWriter *writer) {
+    flush(writer);
+    free(writer->buffer);
+    writer->buffer = NULL;
+    return writer->failed;
+}
@@ -0,0 +1,40 @@
+#ifndef SYMWRITER_H
+#define SYMWRITER_H
+
+#include <stdio.h>
+#include "tokens.h"
+
+//Symbol table output stage: rows are formatted by hand into one big buffer
+//and written out in large blocks instead of one fprintf per token.
+
+typedef enum {
+    SYM_TEXT,   // aligned "lexeme | token | line" table (Symbol Table.txt)
+    SYM_TSV,    // lexeme, token, line separated by tabs, with a header row
+    SYM_JSONL   // one {"lexeme":..,"token":..,"line":..} object per line
+} SymFormat;
+
+#define SYM_BUFFER (1 << 20)
+
+typedef struct {
+    FILE *file;
+    SymFormat format;
+    char *buffer;   // SYM_BUFFER bytes
+    size_t used;
+    int failed;     // a write to file came up short
+} SymWriter;
+
+//name of a token ("O_PLUS", "L_IDENTIFIER", ...)
+const char *tokenValueName(int category, int tokenValue);
+
+//format name as given on the command line ("text", "tsv", "jsonl"), -1 if unknown
+int symFormatParse(const char *name);
+//file the lexer writes for a format ("Symbol Table.txt", ...)
+const char *symFormatFileName(SymFormat format);
+
+void symWriterOpen(SymWriter *writer, FILE *file, SymFormat format);
+void symWriterHeader(SymWriter *writer);
+void symWriterToken(SymWriter *writer, const TokenSpan *t, const char *source);
+//flushes what is left, returns 0 if every byte was written
+int symWriterClose(SymWriter *writer);
+
+#endif
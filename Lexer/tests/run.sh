@@ -0,0 +1,57 @@
+#!/bin/sh
+# Lexer regression tests. Every tests/NAME.usb is lexed on one thread and
+# with --threads 2, 3, 4 and 7, and each run must write exactly
+# tests/NAME.table as its Symbol Table.txt, so chunks cut inside comments
+# are stitched back the same as lexing straight through. The --binary
+# Symbol Table.tok must likewise be the same on every thread count.
+# Each input then goes through tools/relexcheck.c: seeded random edits,
+# re-lexing after each, compared with a full lex token by token; its
+# line of what an edit cost (bytes lexed, tokens shifted, time) is printed.
+# Run from the Lexer folder:  sh tests/run.sh
+# CC picks the compiler. After a deliberate change to the output,
+# sh tests/run.sh --update rewrites the .table files (review the diff).
+cd "$(dirname "$0")/.." || exit 1
+CC=${CC:-cc}
+bin=$(mktemp -d) || exit 1
+trap 'rm -rf "$bin"' EXIT
+
+$CC -O2 -pthread *.c -o "$bin/lexer" -lm || exit 1
+$CC -O2 -pthread tools/relexcheck.c $(ls *.c | grep -v '^main\.c$') -o "$bin/relexcheck" -lm || exit 1
+
+#lex $1 with the options after it; the table is written in the temp folder
+lex() {
+    source=$(pwd)/$1
+    shift
+    (cd "$bin" && ./lexer "$@" "$source" > /dev/null)
+}
+
+failed=0
+for input in tests/*.usb; do
+    table=${input%.usb}.table
+    if [ "$1" = "--update" ]; then
+        lex "$input" && cp "$bin/Symbol Table.txt" "$table"
+    fi
+    for threads in 1 2 3 4 7; do
+        rm -f "$bin/Symbol Table.txt"
+        if ! lex "$input" --threads $threads || ! cmp -s "$bin/Symbol Table.txt" "$table"; then
+            echo "FAIL $input --threads $threads"
+            diff "$table" "$bin/Symbol Table.txt" | head -20
+            failed=1
+        fi
+        lex "$input" --threads $threads --binary && mv "$bin/Symbol Table.tok" "$bin/$threads.tok"
+        if ! cmp -s "$bin/1.tok" "$bin/$threads.tok"; then
+            echo "FAIL $input --threads $threads --binary"
+            failed=1
+        fi
+    done
+    if "$bin/relexcheck" "$input" 1000 1 > "$bin/edits.txt"; then
+        echo "$input: $(cat "$bin/edits.txt")"
+    else
+        echo "FAIL $input (re-lexing)"
+        cat "$bin/edits.txt"
+        failed=1
+    fi
+done
+
+[ $failed = 0 ] && echo "lexer tests passed"
+exit $failed
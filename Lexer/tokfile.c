@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tokfile.h"
+
+static void bufferPut(ByteBuffer *buf, const void *bytes, size_t len) {
+    if (buf->used + len > buf->size) {
+        size_t size = buf->size ? buf->size : 4096;
+        while (size < buf->used + len)
+            size *= 2;
+        unsigned char *grown = realloc(buf->data, size);
+        if (!grown) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        buf->data = grown;
+        buf->size = size;
+    }
+    memcpy(buf->data + buf->used, bytes, len);
+    buf->used += len;
+}
+
+static void putVarint(ByteBuffer *buf, uint32_t value) {
+    unsigned char bytes[5];
+    size_t n = 0;
+    while (value >= 0x80) {
+        bytes[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[n++] = (unsigned char)value;
+    bufferPut(buf, bytes, n);
+}
+
+//reads one varint, NULL if it runs past end or is longer than 32 bits
+static const unsigned char *getVarint(const unsigned char *p, const unsigned char *end, uint32_t *value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        unsigned char byte = *p++;
+        result |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static void putU32(unsigned char *out, uint32_t value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+    out[2] = (unsigned char)(value >> 16);
+    out[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t getU32(const unsigned char *in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static void writeHeader(TokWriter *writer, unsigned char *header) {
+    memset(header, 0, TOKFILE_HEADER);
+    memcpy(header, TOKFILE_MAGIC, 4);
+    header[4] = TOKFILE_VERSION;
+    putU32(header + 8, writer->tokenCount);
+    putU32(header + 12, writer->poolBytes);
+    putU32(header + 16, (uint32_t)writer->lines.used);
+    putU32(header + 20, (uint32_t)writer->lengths.used);
+}
+
+int tokWriterOpen(TokWriter *writer, const char *filename) {
+    unsigned char header[TOKFILE_HEADER];
+
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(filename, "wb");
+    if (!writer->file)
+        return 1;
+    //placeholder, the counts are filled in by tokWriterClose
+    writeHeader(writer, header);
+    fwrite(header, 1, TOKFILE_HEADER, writer->file);
+    return 0;
+}
+
+//the pool goes straight to the file, the small sections wait in memory
+void tokWriterAdd(TokWriter *writer, const TokenSpan *span, const char *source) {
+    unsigned char kind = span->tokenValue;
+
+    fwrite(source + span->offset, 1, span->length, writer->file);
+    fputc('\0', writer->file);
+    writer->poolBytes += span->length + 1;
+
+    bufferPut(&writer->kinds, &kind, 1);
+    putVarint(&writer->lines, span->lineNumber - writer->lastLine);
+    putVarint(&writer->lengths, span->length);
+    writer->lastLine = span->lineNumber;
+    writer->tokenCount++;
+}
+
+int tokWriterClose(TokWriter *writer) {
+    unsigned char header[TOKFILE_HEADER];
+    int failed;
+
+    //the pool and earlier writes are not checked one by one: ferror() keeps
+    //any failure (a full disk) until here
+    failed = fwrite(writer->kinds.data, 1, writer->kinds.used, writer->file) != writer->kinds.used
+          || fwrite(writer->lines.data, 1, writer->lines.used, writer->file) != writer->lines.used
+          || fwrite(writer->lengths.data, 1, writer->lengths.used, writer->file) != writer->lengths.used
+          || fflush(writer->file) != 0 || ferror(writer->file);
+
+    //the real counts go in only over a complete file, so one cut short
+    //keeps the placeholder header and never reads as whole
+    if (!failed) {
+        writeHeader(writer, header);
+        failed = fseek(writer->file, 0, SEEK_SET) != 0
+              || fwrite(header, 1, TOKFILE_HEADER, writer->file) != TOKFILE_HEADER
+              || fflush(writer->file) != 0 || ferror(writer->file);
+    }
+    failed = fclose(writer->file) != 0 || failed;
+
+    free(writer->kinds.data);
+    free(writer->lines.data);
+    free(writer->lengths.data);
+    memset(writer, 0, sizeof(*writer));
+    return failed;
+}
+
+int tokReaderOpen(TokReader *reader, const char *filename) {
+    FILE *file = fopen(filename, "rb");
+
+    memset(reader, 0, sizeof(*reader));
+    if (!file)
+        return 1;
+    if (sourceLoad(&reader->file, file) != 0) {
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+
+    const unsigned char *data = (const unsigned char *)reader->file.data;
+    size_t length = reader->file.length;
+    if (length < TOKFILE_HEADER || memcmp(data, TOKFILE_MAGIC, 4) != 0 || data[4] != TOKFILE_VERSION) {
+        tokReaderClose(reader);
+        return 2;
+    }
+
+    uint32_t count = getU32(data + 8);
+    uint32_t poolBytes = getU32(data + 12);
+    uint32_t lineBytes = getU32(data + 16);
+    uint32_t lengthBytes = getU32(data + 20);
+    //the sections fill the file exactly: shorter is cut off, longer was
+    //never finished (the header still holds the placeholder counts)
+    if ((unsigned long long)TOKFILE_HEADER + poolBytes + count + lineBytes + lengthBytes != length) {
+        tokReaderClose(reader);
+        return 2;
+    }
+
+    reader->tokenCount = count;
+    reader->poolBytes = poolBytes;
+    reader->pool = (const char *)data + TOKFILE_HEADER;
+    reader->kinds = data + TOKFILE_HEADER + poolBytes;
+    reader->lines = reader->kinds + count;
+    reader->linesEnd = reader->lines + lineBytes;
+    reader->lengths = reader->linesEnd;
+    reader->lengthsEnd = reader->lengths + lengthBytes;
+    return 0;
+}
+
+int tokReaderNext(TokReader *reader, TokenSpan *span) {
+    uint32_t delta, length;
+
+    if (reader->index >= reader->tokenCount) {
+        //every section must be used up by the last token
+        if (!reader->damaged && (reader->lines != reader->linesEnd || reader->lengths != reader->lengthsEnd
+                                 || reader->poolOffset != reader->poolBytes))
+            reader->damaged = 1;
+        return 0;
+    }
+    reader->lines = getVarint(reader->lines, reader->linesEnd, &delta);
+    reader->lengths = reader->lines ? getVarint(reader->lengths, reader->lengthsEnd, &length) : NULL;
+    if (!reader->lines || !reader->lengths || length >= reader->poolBytes - reader->poolOffset
+        || reader->pool[reader->poolOffset + length] != '\0') {
+        reader->index = reader->tokenCount; //damaged, stop here
+        reader->damaged = 1;
+        return 0;
+    }
+
+    unsigned char kind = reader->kinds[reader->index++];
+    reader->line += delta;
+    span->offset = reader->poolOffset;
+    span->length = length;
+    span->lineNumber = reader->line;
+    span->category = TOKEN_CATEGORY(kind);
+    span->tokenValue = kind;
+    reader->poolOffset += length + 1;
+    return 1;
+}
+
+void tokReaderClose(TokReader *reader) {
+    if (reader->file.data)
+        sourceRelease(&reader->file);
+    memset(reader, 0, sizeof(*reader));
+}
@@ -0,0 +1,70 @@
+#ifndef TOKFILE_H
+#define TOKFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "tokens.h"
+#include "source.h"
+
+//Binary token stream, the compact alternative to Symbol Table.txt.
+//All integers are little endian.
+//
+//  header   "USBT", version, 3 reserved bytes, then u32 tokenCount,
+//           poolBytes, lineBytes, lengthBytes
+//  pool     every lexeme followed by a NUL, in token order
+//  kinds    one byte per token: the token kind (category << 5 | index)
+//  lines    line number deltas from the previous token, LEB128 varints
+//  lengths  lexeme lengths (without the NUL), LEB128 varints
+//
+//The reader works on one mapping of the file and never copies a lexeme.
+
+#define TOKFILE_MAGIC "USBT"
+#define TOKFILE_VERSION 1
+#define TOKFILE_HEADER 24
+
+typedef struct {
+    unsigned char *data;
+    size_t used;
+    size_t size;
+} ByteBuffer;
+
+typedef struct {
+    FILE *file;
+    ByteBuffer kinds, lines, lengths;  // sections written after the pool
+    uint32_t tokenCount;
+    uint32_t poolBytes;
+    uint32_t lastLine;
+} TokWriter;
+
+typedef struct {
+    SourceBuffer file;
+    const unsigned char *kinds;
+    const unsigned char *lines, *linesEnd;
+    const unsigned char *lengths, *lengthsEnd;
+    const char *pool;
+    uint32_t tokenCount;
+    uint32_t poolBytes;
+    //position of the next token
+    uint32_t index;
+    uint32_t line;
+    uint32_t poolOffset;
+    int damaged;          // a section ran short or had bytes left over
+} TokReader;
+
+//returns 0 on success like sourceLoad
+int tokWriterOpen(TokWriter *writer, const char *filename);
+void tokWriterAdd(TokWriter *writer, const TokenSpan *span, const char *source);
+//nonzero if any write failed; the file then does not open as a stream
+int tokWriterClose(TokWriter *writer);
+
+//0 on success, 1 if the file cannot be read, 2 if it is not a whole
+//token stream (wrong header, cut short, or never finished)
+int tokReaderOpen(TokReader *reader, const char *filename);
+
+//next token, span->offset indexes reader->pool where the lexeme is NUL
+//terminated; returns 0 after the last token or on a damaged file, which
+//sets reader->damaged
+int tokReaderNext(TokReader *reader, TokenSpan *span);
+void tokReaderClose(TokReader *reader);
+
+#endif
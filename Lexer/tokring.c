@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "tokring.h"
+
+int tokRingInit(TokenRing *ring, size_t slots) {
+    size_t size = 1;
+    while (size < slots)
+        size <<= 1;
+    ring->slots = malloc(size * sizeof(TokenSpan));
+    if (!ring->slots)
+        return 1;
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->closed, 0);
+    atomic_init(&ring->abandoned, 0);
+    ring->tailSeen = 0;
+    ring->headSeen = 0;
+    return 0;
+}
+
+void tokRingFree(TokenRing *ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+int tokRingPush(TokenRing *ring, const TokenSpan *tok) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    //only go to the shared tail when the cached one says full
+    while (head - ring->tailSeen > ring->mask) {
+        ring->tailSeen = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head - ring->tailSeen <= ring->mask)
+            break;
+        if (atomic_load_explicit(&ring->abandoned, memory_order_relaxed))
+            return 0;
+        sched_yield(); //full: let the parser catch up
+    }
+    ring->slots[head & ring->mask] = *tok;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return 1;
+}
+
+void tokRingClose(TokenRing *ring) {
+    atomic_store_explicit(&ring->closed, 1, memory_order_release);
+}
+
+int tokRingPop(TokenRing *ring, TokenSpan *tok) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    while (tail == ring->headSeen) {
+        int closed = atomic_load_explicit(&ring->closed, memory_order_acquire);
+        ring->headSeen = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail != ring->headSeen)
+            break;
+        if (closed)
+            return 0; //closed before head was read, so nothing more is coming
+        sched_yield(); //empty: let the lexer catch up
+    }
+    *tok = ring->slots[tail & ring->mask];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+void tokRingAbandon(TokenRing *ring) {
+    atomic_store_explicit(&ring->abandoned, 1, memory_order_relaxed);
+}
@@ -0,0 +1,41 @@
+#ifndef TOKRING_H
+#define TOKRING_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "tokens.h"
+
+//Bounded lock-free ring for handing tokens from one producer thread (the
+//lexer) to one consumer thread (the parser). A full ring makes the producer
+//wait, an empty one the consumer, so memory stays at the ring size however
+//big the input is.
+
+#define TOKRING_DEFAULT_SLOTS (64 * 1024)
+
+typedef struct {
+    TokenSpan *slots;
+    size_t mask;                     // slot count - 1 (a power of two)
+
+    _Alignas(64) atomic_size_t head;  // next slot the producer writes
+    size_t tailSeen;                 // producer's last look at tail
+
+    _Alignas(64) atomic_size_t tail;  // next slot the consumer reads
+    size_t headSeen;                 // consumer's last look at head
+
+    _Alignas(64) atomic_int closed;   // producer is done, no more tokens
+    atomic_int abandoned;            // consumer stopped reading
+} TokenRing;
+
+//slots is rounded up to a power of two, returns 0 on success
+int tokRingInit(TokenRing *ring, size_t slots);
+void tokRingFree(TokenRing *ring);
+
+//producer: returns 0 if the consumer has abandoned the ring
+int tokRingPush(TokenRing *ring, const TokenSpan *tok);
+void tokRingClose(TokenRing *ring);
+
+//consumer: returns 0 once the ring is closed and drained
+int tokRingPop(TokenRing *ring, TokenSpan *tok);
+void tokRingAbandon(TokenRing *ring);
+
+#endif
@@ -0,0 +1,137 @@
+//Checks relex() against lexing from scratch: applies random edits to a
+//source file and after each one compares the updated token list with a
+//full lex of the new text, field by field. The summary line gives what an
+//edit costs: bytes lexed, tokens shifted behind it, and the time of
+//relex() next to the time of the full lex.
+//Build and run from the Lexer folder:
+//  gcc -O2 -pthread tools/relexcheck.c relex.c lexer.c WordHash.c simdscan.c source.c arena.c -o relexcheck
+//  ./relexcheck file.usb [edits] [seed]
+//Prints the first mismatches and exits 1 if there were any.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../lexer.h"
+#include "../relex.h"
+#include "../source.h"
+
+#define SHOWN_MISMATCHES 3
+
+//small fixed generator so a seed gives the same edits everywhere
+static unsigned long long randomState;
+
+static size_t randomBelow(size_t bound) {
+    randomState = randomState * 6364136223846793005ull + 1442695040888963407ull;
+    return bound ? (size_t)(randomState >> 33) % bound : 0;
+}
+
+//text an edit puts in: pieces that open or close tokens more often than not
+static const char *const insertions[] = {
+    "", "a", "\n", "/*", "*/", "\"", "x y", "//", "kung", "1.5", "&&", "'", "  ",
+    "\n\n", "*", "=", "bilang z = 2;\n", "wala ugat ( ) {", "}"
+};
+
+static void lexAll(const char *source, size_t length, TokenList *list) {
+    LexerCtx ctx;
+    TokenSpan tok;
+    memset(list, 0, sizeof(*list));
+    lexer_init(&ctx, source, length);
+    while (lexer_next(&ctx, &tok))
+        tokenListPush(list, &tok);
+}
+
+//index of the first token that differs, count if none does
+static size_t firstDifference(const TokenList *a, const TokenList *b) {
+    size_t count = a->count < b->count ? a->count : b->count;
+    for (size_t i = 0; i < count; i++) {
+        const TokenSpan *x = &a->tokens[i], *y = &b->tokens[i];
+        if (x->offset != y->offset || x->length != y->length || x->lineNumber != y->lineNumber
+            || x->category != y->category || x->tokenValue != y->tokenValue)
+            return i;
+    }
+    return a->count == b->count ? SIZE_MAX : count;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: relexcheck file.usb [edits] [seed]\n");
+        return 2;
+    }
+    int edits = argc > 2 ? atoi(argv[2]) : 1000;
+    randomState = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+
+    FILE *file = fopen(argv[1], "r");
+    SourceBuffer src;
+    if (!file || sourceLoad(&src, file) != 0) {
+        fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 2;
+    }
+    fclose(file);
+    initialize_lexer();
+
+    size_t length = src.length;
+    char *text = malloc(length + 1);
+    if (!text) {
+        fprintf(stderr, "Error: out of memory\n");
+        return 2;
+    }
+    memcpy(text, src.data, length);
+    sourceRelease(&src);
+
+    TokenList tokens, fresh;
+    lexAll(text, length, &tokens);
+    int mismatches = 0;
+    size_t lexedBytes = 0, shiftedTokens = 0;
+    clock_t relexTime = 0, lexTime = 0;
+    for (int i = 0; i < edits; i++) {
+        RelexEdit edit;
+        edit.offset = randomBelow(length + 1);
+        edit.removed = randomBelow(4);
+        if (edit.offset + edit.removed > length)
+            edit.removed = length - edit.offset;
+        const char *inserted = insertions[randomBelow(sizeof(insertions) / sizeof(insertions[0]))];
+        edit.inserted = strlen(inserted);
+
+        size_t newLength = length - edit.removed + edit.inserted;
+        char *edited = malloc(newLength + 1);
+        if (!edited) {
+            fprintf(stderr, "Error: out of memory\n");
+            return 2;
+        }
+        memcpy(edited, text, edit.offset);
+        memcpy(edited + edit.offset, inserted, edit.inserted);
+        memcpy(edited + edit.offset + edit.inserted, text + edit.offset + edit.removed,
+               length - edit.offset - edit.removed);
+
+        clock_t start = clock();
+        RelexResult result = relex(&tokens, edited, newLength, &edit);
+        clock_t middle = clock();
+        lexAll(edited, newLength, &fresh);
+        relexTime += middle - start;
+        lexTime += clock() - middle;
+        lexedBytes += result.lexedBytes;
+        shiftedTokens += result.shiftedTokens;
+        size_t at = firstDifference(&tokens, &fresh);
+        if (at != SIZE_MAX && mismatches++ < SHOWN_MISMATCHES)
+            printf("edit %d (offset %zu, removed %zu, inserted '%s'): token %zu differs, %zu tokens vs %zu\n",
+                   i, edit.offset, edit.removed, inserted, at, tokens.count, fresh.count);
+        if (at != SIZE_MAX) { //carry on from the right tokens
+            tokenListFree(&tokens);
+            tokens = fresh;
+        } else {
+            tokenListFree(&fresh);
+        }
+        free(text);
+        text = edited;
+        length = newLength;
+    }
+
+    double perEdit = edits ? 1.0 / edits : 0.0;
+    printf("%d edits, %d mismatches, per edit: %.1f bytes lexed, %.0f tokens shifted, "
+           "%.1f us in relex() against %.1f us for a full lex\n", edits, mismatches,
+           lexedBytes * perEdit, shiftedTokens * perEdit,
+           relexTime * perEdit * 1e6 / CLOCKS_PER_SEC, lexTime * perEdit * 1e6 / CLOCKS_PER_SEC);
+    tokenListFree(&tokens);
+    free(text);
+    return mismatches ? 1 : 0;
+}
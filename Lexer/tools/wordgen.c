@@ -0,0 +1,117 @@
+//Generates the static word table in WordHash.c.
+//Build and run from the Lexer folder after changing the word list:
+//  gcc tools/wordgen.c -o wordgen && ./wordgen
+//then paste the output over the generated block in WordHash.c.
+//
+//The hash uses the first, second and last byte plus the length, and the
+//multipliers are searched until every word gets a slot of its own.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SLOTS 64
+
+typedef struct {
+    const char *word;
+    const char *category;
+    const char *tokenValue;
+} WordDef;
+
+static const WordDef words[] = {
+    {"ani", "CAT_KEYWORD", "K_ANI"},
+    {"tanim", "CAT_KEYWORD", "K_TANIM"},
+    {"para", "CAT_KEYWORD", "K_PARA"},
+    {"habang", "CAT_KEYWORD", "K_HABANG"},
+    {"kung", "CAT_KEYWORD", "K_KUNG"},
+    {"kundi", "CAT_KEYWORD", "K_KUNDI"},
+    {"kundiman", "CAT_KEYWORD", "K_KUNDIMAN"},
+    {"gawin", "CAT_KEYWORD", "K_GAWIN"},
+    {"tibag", "CAT_KEYWORD", "K_TIBAG"},
+    {"tuloy", "CAT_KEYWORD", "K_TULOY"},
+    {"pangkat", "CAT_KEYWORD", "K_PANGKAT"},
+    {"statik", "CAT_KEYWORD", "K_STATIK"},
+    {"pribado", "CAT_KEYWORD", "K_PRIBADO"},
+    {"protektado", "CAT_KEYWORD", "K_PROTEKTADO"},
+    {"publiko", "CAT_KEYWORD", "K_PUBLIKO"},
+    {"tama", "CAT_RESERVED", "R_TAMA"},
+    {"mali", "CAT_RESERVED", "R_MALI"},
+    {"ugat", "CAT_RESERVED", "R_UGAT"},
+    {"balik", "CAT_RESERVED", "R_BALIK"},
+    {"bilang", "CAT_RESERVED", "R_BILANG"},
+    {"kwerdas", "CAT_RESERVED", "R_KWERDAS"},
+    {"titik", "CAT_RESERVED", "R_TITIK"},
+    {"lutang", "CAT_RESERVED", "R_LUTANG"},
+    {"bulyan", "CAT_RESERVED", "R_BULYAN"},
+    {"doble", "CAT_RESERVED", "R_DOBLE"},
+    {"wala", "CAT_RESERVED", "R_WALA"},
+    {"ng", "CAT_NOISEWORD", "N_NG"},
+    {"ay", "CAT_NOISEWORD", "N_AY"},
+    {"bunga", "CAT_NOISEWORD", "N_BUNGA"},
+    {"wakas", "CAT_NOISEWORD", "N_WAKAS"},
+    {"sa", "CAT_NOISEWORD", "N_SA"},
+    {"ang", "CAT_NOISEWORD", "N_ANG"},
+    {"mula", "CAT_NOISEWORD", "N_MULA"},
+    {"itakda", "CAT_NOISEWORD", "N_ITAKDA"},
+    {"pi", "CAT_RESERVED", "R_PI"},
+    {"E_num", "CAT_RESERVED", "R_E_NUM"},
+    {"kiss", "CAT_RESERVED", "R_Kiss"},
+    {"sampleConstString", "CAT_RESERVED", "R_SAMPLE_CONST_STRING"},
+};
+
+#define WORDS (sizeof(words) / sizeof(words[0]))
+
+static unsigned slotOf(const char *w, unsigned a, unsigned b, unsigned c) {
+    size_t n = strlen(w);
+    return ((unsigned char)w[0] * a + (unsigned char)w[1] * b + (unsigned char)w[n - 1] * c + (unsigned)n) & (SLOTS - 1);
+}
+
+int main(void) {
+    size_t minLength = 1000, maxLength = 0;
+    for (size_t i = 0; i < WORDS; i++) {
+        size_t n = strlen(words[i].word);
+        if (n < 2) {
+            fprintf(stderr, "Error: '%s' is shorter than 2 characters\n", words[i].word);
+            return 1;
+        }
+        if (n < minLength) minLength = n;
+        if (n > maxLength) maxLength = n;
+    }
+
+    for (unsigned a = 1; a < SLOTS; a++) {
+        for (unsigned b = 1; b < SLOTS; b++) {
+            for (unsigned c = 1; c < SLOTS; c++) {
+                int used[SLOTS] = {0};
+                const WordDef *slot[SLOTS] = {0};
+                size_t i;
+                for (i = 0; i < WORDS; i++) {
+                    unsigned h = slotOf(words[i].word, a, b, c);
+                    if (used[h])
+                        break;
+                    used[h] = 1;
+                    slot[h] = &words[i];
+                }
+                if (i < WORDS)
+                    continue;
+
+                printf("// ---- generated by tools/wordgen.c, do not edit by hand ----\n");
+                printf("#define WORD_SLOTS %d\n", SLOTS);
+                printf("#define WORD_MIN_LENGTH %zu\n", minLength);
+                printf("#define WORD_MAX_LENGTH %zu\n", maxLength);
+                printf("#define WORD_HASH(first, second, last, length) \\\n");
+                printf("    (((first) * %uu + (second) * %uu + (last) * %uu + (length)) & (WORD_SLOTS - 1))\n\n", a, b, c);
+                printf("static const HashEntry wordTable[WORD_SLOTS] = {\n");
+                for (unsigned h = 0; h < SLOTS; h++) {
+                    if (!slot[h])
+                        continue;
+                    printf("    [%2u] = {\"%s\", %zu, %s, %s},\n", h, slot[h]->word,
+                           strlen(slot[h]->word), slot[h]->category, slot[h]->tokenValue);
+                }
+                printf("};\n");
+                printf("// ---- end of generated block ----\n");
+                return 0;
+            }
+        }
+    }
+    fprintf(stderr, "Error: no perfect hash with %d slots, raise SLOTS\n", SLOTS);
+    return 1;
+}
@@ -1,26 +1,22 @@
 #ifndef WORDHASH_H
 #define WORDHASH_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include "tokens.h"
 
 //HASH TABLE STUFF
-#define TABLE_SIZE 100
-#define MAX 100
-
 typedef struct {
-    char key[MAX];
-    TokenCategory category;
-    int tokenValue;
+    const char *key;     // the word (not padded)
+    uint8_t length;      // strlen(key), 0 for an empty slot
+    uint8_t category;    // TokenCategory
+    uint8_t tokenValue;
 } HashEntry;
 
-extern HashEntry hash_table[TABLE_SIZE]; //declare hash table
-
 //function prototypes
-unsigned int hash(const char *key);
-void hashhashInsert(const char *key, TokenCategory category, int token_value);
-HashEntry* hashLookUp(const char *key);
-void initialize_table(void);
+const HashEntry *wordLookup(const char *text, size_t length);
+const HashEntry *hashLookUp(const char *key);
 
 
 // new function for parser to use
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ast.h"
+#include "../Lexer/tokens.h"
+#include "../Lexer/symwriter.h"
+
+void astInit(Ast *ast) {
+    ast->nodes = NULL;
+    ast->count = ast->capacity = 0;
+    ast->root = AST_NONE;
+}
+
+void astReset(Ast *ast) {
+    ast->count = 0;
+    ast->root = AST_NONE;
+}
+
+void astFree(Ast *ast) {
+    free(ast->nodes);
+    astInit(ast);
+}
+
+void astGrow(Ast *ast) {
+    uint32_t capacity = ast->capacity ? ast->capacity * 2 : 4096;
+    AstNode *grown = realloc(ast->nodes, (size_t)capacity * sizeof(AstNode));
+    if (!grown) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    ast->nodes = grown;
+    ast->capacity = capacity;
+}
+
+const char *astKindName(AstKind kind) {
+    switch (kind) {
+        case AST_PROGRAM: return "Program";
+        case AST_FUNCTION: return "Function";
+        case AST_BLOCK: return "Block";
+        case AST_DECLARATION: return "Declaration";
+        case AST_DECLARATOR: return "Declarator";
+        case AST_ASSIGNMENT: return "Assignment";
+        case AST_KUNG: return "Kung";
+        case AST_KUNDIMAN: return "Kundiman";
+        case AST_KUNDI: return "Kundi";
+        case AST_PARA: return "Para";
+        case AST_HABANG: return "Habang";
+        case AST_GAWIN: return "Gawin";
+        case AST_BINARY: return "Binary";
+        case AST_UNARY: return "Unary";
+        case AST_IDENTIFIER: return "Identifier";
+        case AST_LITERAL: return "Literal";
+        case AST_ERROR: return "Error";
+        default: return "Unknown";
+    }
+}
+
+static void printNode(const AstNode *node, size_t depth, FILE *file) {
+    fprintf(file, "%*s%s", (int)(depth * 2), "", astKindName((AstKind)node->kind));
+    if (node->kind == AST_DECLARATION || node->kind == AST_BINARY || node->kind == AST_UNARY
+        || node->kind == AST_LITERAL)
+        fprintf(file, " %s", tokenValueName(TOKEN_CATEGORY(node->token), node->token));
+    if (node->text)
+        fprintf(file, " '%.*s'", (int)node->length, node->text);
+    fprintf(file, " (line %u)\n", node->line);
+}
+
+//preorder through the indices: each open inner node leaves its next
+//sibling on a heap stack, so deep trees cost no C stack
+void astPrint(const Ast *ast, FILE *file) {
+    AstIndex *after = NULL;
+    size_t depth = 0, capacity = 0;
+    AstIndex index = ast->root;
+
+    while (index != AST_NONE || depth > 0) {
+        if (index == AST_NONE) {
+            index = after[--depth];
+            continue;
+        }
+        const AstNode *node = &ast->nodes[index];
+        printNode(node, depth, file);
+        if (node->text || node->firstChild == AST_NONE) {
+            index = node->nextSibling;
+            continue;
+        }
+        if (depth == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            AstIndex *grown = realloc(after, capacity * sizeof(AstIndex));
+            if (!grown) {
+                fprintf(stderr, "Error: out of memory\n");
+                exit(1);
+            }
+            after = grown;
+        }
+        after[depth++] = node->nextSibling;
+        index = node->firstChild;
+    }
+    free(after);
+}
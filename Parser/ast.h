@@ -0,0 +1,125 @@
+#ifndef AST_H
+#define AST_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+//Syntax tree built by the parser. Every node has the same size and they all
+//sit in one array: children are found through indices (first child, next
+//sibling), never pointers, so the array can grow and the whole tree goes
+//away with one free.
+
+typedef uint32_t AstIndex;
+#define AST_NONE UINT32_MAX  // no node
+
+typedef enum {
+    AST_PROGRAM,      // functions
+    AST_FUNCTION,     // wala ugat ( ) { block }
+    AST_BLOCK,        // statements
+    AST_DECLARATION,  // token = data type; declarators
+    AST_DECLARATOR,   // name identifier, [array size], [initializer] (see flags)
+    AST_ASSIGNMENT,   // target identifier, value
+    AST_KUNG,         // condition, block, [kundiman], [kundi]
+    AST_KUNDIMAN,     // condition, block
+    AST_KUNDI,        // block
+    AST_PARA,         // init assignment, condition, update assignment, block
+    AST_HABANG,       // condition, block
+    AST_GAWIN,        // block, condition
+    AST_BINARY,       // token = operator; left, right
+    AST_UNARY,        // token = operator; operand
+    AST_IDENTIFIER,   // text = name
+    AST_LITERAL,      // token = literal kind, text = lexeme
+    AST_ERROR         // a factor the parser could not read
+} AstKind;
+
+//AST_DECLARATOR flags
+#define AST_ARRAY 1        // a [size] follows the name (the size child is missing if it was)
+#define AST_INITIALIZED 2  // last child is the initializer
+
+//a node has either children (inner nodes) or text (leaves), never both
+typedef struct {
+    uint8_t kind;          // AstKind
+    uint8_t token;         // token kind, see the node kinds
+    uint8_t flags;
+    uint8_t reserved;
+    uint32_t line;
+    AstIndex nextSibling;
+    union {
+        AstIndex firstChild;  // inner nodes
+        uint32_t length;      // leaves: bytes of text
+    };
+    const char *text;      // leaves: lexeme in the parser's tokens or source (not NUL terminated)
+} AstNode;                 // 24 bytes
+
+typedef struct {
+    AstNode *nodes;
+    uint32_t count, capacity;
+    AstIndex root;         // AST_PROGRAM once a parse is done
+} Ast;
+
+//builds children in order without walking the sibling chain
+typedef struct {
+    AstIndex parent, last;
+} AstChildren;
+
+void astInit(Ast *ast);
+//forget every node but keep the array for the next parse
+void astReset(Ast *ast);
+void astFree(Ast *ast);
+
+//make room for more nodes (astNew calls it when the array is full)
+void astGrow(Ast *ast);
+
+//append an inner node, children added later
+static inline AstIndex astNew(Ast *ast, AstKind kind, int token, uint32_t line) {
+    if (ast->count == ast->capacity)
+        astGrow(ast);
+    AstNode *node = &ast->nodes[ast->count];
+    node->kind = (uint8_t)kind;
+    node->token = (uint8_t)token;
+    node->flags = 0;
+    node->reserved = 0;
+    node->line = line;
+    node->nextSibling = AST_NONE;
+    node->firstChild = AST_NONE;
+    node->text = NULL;
+    return ast->count++;
+}
+
+//append a leaf for a token's text
+static inline AstIndex astLeaf(Ast *ast, AstKind kind, int token, uint32_t line, const char *text, uint32_t length) {
+    if (ast->count == ast->capacity)
+        astGrow(ast);
+    AstNode *node = &ast->nodes[ast->count];
+    node->kind = (uint8_t)kind;
+    node->token = (uint8_t)token;
+    node->flags = 0;
+    node->reserved = 0;
+    node->line = line;
+    node->nextSibling = AST_NONE;
+    node->length = length;
+    node->text = text;
+    return ast->count++;
+}
+
+static inline AstChildren astChildren(AstIndex parent) {
+    AstChildren children = { parent, AST_NONE };
+    return children;
+}
+
+//append child (AST_NONE is skipped)
+static inline void astAdd(Ast *ast, AstChildren *children, AstIndex child) {
+    if (child == AST_NONE || children->parent == AST_NONE)
+        return;
+    if (children->last == AST_NONE)
+        ast->nodes[children->parent].firstChild = child;
+    else
+        ast->nodes[children->last].nextSibling = child;
+    children->last = child;
+}
+
+const char *astKindName(AstKind kind);
+//indented outline of the tree, one node per line
+void astPrint(const Ast *ast, FILE *file);
+
+#endif
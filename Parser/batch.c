@@ -0,0 +1,351 @@
+//lstat() and S_ISLNK are not C11, ask the C library for them
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "batch.h"
+#include "parser.h"
+#include "../Lexer/source.h"
+#include "../Lexer/symwriter.h"
+
+#define MAX_WORKERS 256
+
+typedef enum {
+    FILE_CLEAN,
+    FILE_SYNTAX_ERRORS,
+    FILE_FAILED
+} FileStatus;
+
+typedef struct {
+    char *path;
+    long long size;
+    FileStatus status;
+    int errors;
+} BatchFile;
+
+//one worker's files; the owner takes from head (biggest), thieves from tail
+typedef struct {
+    BatchFile **jobs;
+    int head, tail;
+    pthread_mutex_t lock;
+} JobQueue;
+
+typedef struct {
+    JobQueue *queues;
+    int workers;
+} Pool;
+
+typedef struct {
+    Pool *pool;
+    int id;
+} Worker;
+
+typedef struct {
+    BatchFile *files;
+    int count, capacity;
+} FileList;
+
+static void addFile(FileList *list, const char *path, long long size) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        BatchFile *grown = realloc(list->files, (size_t)capacity * sizeof(BatchFile));
+        if (!grown) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        list->files = grown;
+        list->capacity = capacity;
+    }
+    BatchFile *file = &list->files[list->count++];
+    file->path = malloc(strlen(path) + 1);
+    if (!file->path) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    strcpy(file->path, path);
+    file->size = size;
+    file->status = FILE_FAILED;
+    file->errors = 0;
+}
+
+static int isUsb(const char *name) {
+    const char *dot = strrchr(name, '.');
+    return dot && strcmp(dot, ".usb") == 0;
+}
+
+//every .usb file under dir, subfolders included
+static void collectDirectory(FileList *list, const char *dir) {
+    DIR *handle = opendir(dir);
+    struct dirent *entry;
+
+    if (!handle) {
+        printf("Cannot open folder %s\n", dir);
+        return;
+    }
+    while ((entry = readdir(handle)) != NULL) {
+        struct stat st;
+        char *path;
+
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+        path = malloc(strlen(dir) + strlen(entry->d_name) + 2);
+        if (!path) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        sprintf(path, "%s/%s", dir, entry->d_name);
+        //links are not followed into folders (a link back up would never
+        //end), a link to a file counts as that file
+        if (lstat(path, &st) == 0) {
+            if (S_ISDIR(st.st_mode))
+                collectDirectory(list, path);
+            else if (S_ISLNK(st.st_mode) && stat(path, &st) != 0)
+                ; //dangling
+            else if (S_ISREG(st.st_mode) && isUsb(entry->d_name))
+                addFile(list, path, (long long)st.st_size);
+        }
+        free(path);
+    }
+    closedir(handle);
+}
+
+static void collectPath(FileList *list, const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        //still listed so the summary reports it
+        addFile(list, path, 0);
+        return;
+    }
+    if (S_ISDIR(st.st_mode))
+        collectDirectory(list, path);
+    else
+        addFile(list, path, (long long)st.st_size);
+}
+
+static int biggestFirst(const void *a, const void *b) {
+    const BatchFile *x = *(BatchFile *const *)a;
+    const BatchFile *y = *(BatchFile *const *)b;
+    return (x->size < y->size) - (x->size > y->size);
+}
+
+static int cpuCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+//path with suffix appended, caller frees
+static char *withSuffix(const char *path, const char *suffix) {
+    char *name = malloc(strlen(path) + strlen(suffix) + 1);
+    if (!name) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    strcpy(name, path);
+    strcat(name, suffix);
+    return name;
+}
+
+static int writeSymbols(const TokenList *tokens, const char *source, const char *path) {
+    char *name = withSuffix(path, ".symbols.txt");
+    FILE *out = fopen(name, "w");
+    SymWriter symbols;
+    int failed;
+
+    free(name);
+    if (!out)
+        return 0;
+    symWriterOpen(&symbols, out, SYM_TEXT);
+    symWriterHeader(&symbols);
+    for (size_t i = 0; i < tokens->count; i++)
+        symWriterToken(&symbols, &tokens->tokens[i], source);
+    failed = symWriterClose(&symbols);
+    return fclose(out) == 0 && !failed;
+}
+
+//lex one file once into tokens (the worker's, reused), then write its
+//symbol table and parse it from that list; the parser talks to the
+//file's own diagnostics file
+static void processFile(BatchFile *file, TokenList *tokens) {
+    FILE *in = fopen(file->path, "r");
+    SourceBuffer src;
+    LexerCtx lexer;
+    TokenSpan tok;
+
+    file->status = FILE_FAILED;
+    if (!in)
+        return;
+    if (sourceLoad(&src, in) != 0) {
+        fclose(in);
+        return;
+    }
+    fclose(in);
+
+    tokens->count = 0;
+    lexer_init(&lexer, src.data, src.length);
+    while (lexer_next(&lexer, &tok))
+        tokenListPush(tokens, &tok);
+
+    char *name = withSuffix(file->path, ".diagnostics.txt");
+    FILE *diagnostics = fopen(name, "w");
+    free(name);
+    if (diagnostics && writeSymbols(tokens, src.data, file->path)) {
+        setParserOutput(diagnostics);
+        attachTokenList(tokens, src.data);
+        parseProgram();
+        file->errors = syntaxErrorCount();
+        freeTokens();
+        setParserOutput(NULL);
+        file->status = file->errors ? FILE_SYNTAX_ERRORS : FILE_CLEAN;
+    }
+    if (diagnostics && fclose(diagnostics) != 0)
+        file->status = FILE_FAILED;
+    sourceRelease(&src);
+}
+
+static BatchFile *takeOwn(JobQueue *queue) {
+    BatchFile *job = NULL;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->head < queue->tail)
+        job = queue->jobs[queue->head++];
+    pthread_mutex_unlock(&queue->lock);
+    return job;
+}
+
+static BatchFile *steal(JobQueue *queue) {
+    BatchFile *job = NULL;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->head < queue->tail)
+        job = queue->jobs[--queue->tail];
+    pthread_mutex_unlock(&queue->lock);
+    return job;
+}
+
+static void *workerMain(void *arg) {
+    Worker *self = arg;
+    Pool *pool = self->pool;
+    TokenList tokens = { NULL, 0, 0 };
+    setParserStackLimit(PARSER_NESTING_LIMIT); //generated files can nest deeper than a thread stack allows
+
+    while (1) {
+        BatchFile *job = takeOwn(&pool->queues[self->id]);
+        //own queue empty: rob the others, nobody adds work so all empty = done
+        for (int i = 1; !job && i < pool->workers; i++)
+            job = steal(&pool->queues[(self->id + i) % pool->workers]);
+        if (!job)
+            break;
+        processFile(job, &tokens);
+    }
+    tokenListFree(&tokens);
+    return NULL;
+}
+
+int runBatch(char **paths, int pathCount, int jobs) {
+    FileList list = { NULL, 0, 0 };
+    int status = 0;
+
+    for (int i = 0; i < pathCount; i++)
+        collectPath(&list, paths[i]);
+    if (list.count == 0) {
+        printf("No .usb files found\n");
+        return 2;
+    }
+
+    int workers = jobs > 0 ? jobs : cpuCount();
+    if (workers > list.count)
+        workers = list.count;
+    if (workers > MAX_WORKERS)
+        workers = MAX_WORKERS;
+
+    //biggest files first, dealt round robin so every queue is sorted too
+    BatchFile **order = malloc((size_t)list.count * sizeof(BatchFile *));
+    Pool pool;
+    pool.workers = workers;
+    pool.queues = calloc((size_t)workers, sizeof(JobQueue));
+    if (!order || !pool.queues) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    for (int i = 0; i < list.count; i++)
+        order[i] = &list.files[i];
+    qsort(order, (size_t)list.count, sizeof(BatchFile *), biggestFirst);
+    for (int w = 0; w < workers; w++) {
+        JobQueue *queue = &pool.queues[w];
+        queue->jobs = malloc(((size_t)list.count / workers + 1) * sizeof(BatchFile *));
+        if (!queue->jobs) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        pthread_mutex_init(&queue->lock, NULL);
+    }
+    for (int i = 0; i < list.count; i++) {
+        JobQueue *queue = &pool.queues[i % workers];
+        queue->jobs[queue->tail++] = order[i];
+    }
+
+    initialize_lexer(); //shared tables, set up before any thread reads them
+
+    pthread_t threads[MAX_WORKERS];
+    Worker self[MAX_WORKERS];
+    int started[MAX_WORKERS] = {0};
+    for (int w = 1; w < workers; w++) {
+        self[w].pool = &pool;
+        self[w].id = w;
+        started[w] = pthread_create(&threads[w], NULL, workerMain, &self[w]) == 0;
+    }
+    self[0].pool = &pool;
+    self[0].id = 0;
+    workerMain(&self[0]); //this thread is worker 0, and steals the queues of threads that did not start
+    for (int w = 1; w < workers; w++) {
+        if (started[w])
+            pthread_join(threads[w], NULL);
+    }
+
+    int clean = 0, withErrors = 0, failed = 0;
+    for (int i = 0; i < list.count; i++) {
+        BatchFile *file = &list.files[i];
+        switch (file->status) {
+            case FILE_CLEAN:
+                printf("%s: ok\n", file->path);
+                clean++;
+                break;
+            case FILE_SYNTAX_ERRORS:
+                printf("%s: %d syntax error%s\n", file->path, file->errors, file->errors == 1 ? "" : "s");
+                withErrors++;
+                if (status < 1) status = 1;
+                break;
+            default:
+                printf("%s: could not be read or written\n", file->path);
+                failed++;
+                status = 2;
+                break;
+        }
+        free(file->path);
+    }
+    printf("%d file%s on %d worker%s: %d ok, %d with syntax errors, %d failed\n",
+           list.count, list.count == 1 ? "" : "s", workers, workers == 1 ? "" : "s",
+           clean, withErrors, failed);
+
+    for (int w = 0; w < workers; w++) {
+        pthread_mutex_destroy(&pool.queues[w].lock);
+        free(pool.queues[w].jobs);
+    }
+    free(pool.queues);
+    free(order);
+    free(list.files);
+    return status;
+}
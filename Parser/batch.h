@@ -0,0 +1,15 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+//Batch mode: lex and parse many .usb files at once on a pool of worker
+//threads. Each worker owns a queue of files (biggest first) and steals from
+//the others once its own queue runs dry. For every file.usb it writes
+//file.usb.symbols.txt (symbol table) and file.usb.diagnostics.txt (parser
+//messages), then a summary goes to stdout.
+
+//paths are files or directories (searched for *.usb), jobs <= 0 means one
+//worker per CPU. Returns the exit status: 0 all clean, 1 some file had
+//syntax errors, 2 some file could not be read or written
+int runBatch(char **paths, int pathCount, int jobs);
+
+#endif
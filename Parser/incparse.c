@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "incparse.h"
+#include "parser.h"
+#include "../Lexer/arena.h"
+
+//where the parser is between segments
+enum {
+    IN_FUNCTIONS,  // before a function or at the end of the program
+    IN_BODY        // inside a function body
+};
+
+static int startState(int kind) {
+    return kind == SEG_FUNC_HEAD ? IN_FUNCTIONS : IN_BODY;
+}
+
+static void *grow(void *items, size_t *capacity, size_t need, size_t itemSize) {
+    if (need <= *capacity)
+        return items;
+    size_t size = *capacity ? *capacity : 256;
+    while (size < need)
+        size *= 2;
+    void *grown = realloc(items, size * itemSize);
+    if (!grown) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    *capacity = size;
+    return grown;
+}
+
+//syntax error sink: the parser's errors land in the fresh diagnostics
+static void collectError(void *context, size_t tokenIndex, const char *message) {
+    IncParse *parse = context;
+    parse->freshDiagnostics = grow(parse->freshDiagnostics, &parse->freshDiagnosticCapacity,
+                                   parse->freshDiagnosticCount + 1, sizeof(ParseDiagnostic));
+    parse->freshDiagnostics[parse->freshDiagnosticCount].token = tokenIndex;
+    parse->freshDiagnostics[parse->freshDiagnosticCount].message = message;
+    parse->freshDiagnosticCount++;
+}
+
+void incParseInit(IncParse *parse) {
+    memset(parse, 0, sizeof(*parse));
+}
+
+//parse segments into the fresh lists from token index at in state until
+//the program ends or a segment boundary lines up with old segment
+//*resume (searched from there on, shifted by shift, only those starting
+//at or after dirtyEnd). Returns 1 when it lined up.
+static int parseSegments(IncParse *parse, const TokenList *tokens, const char *source,
+                         size_t at, int state, size_t *resume, size_t dirtyEnd, long long shift) {
+    size_t j = *resume;
+    int synced = 0;
+
+    parse->freshSegmentCount = 0;
+    parse->freshDiagnosticCount = 0;
+    attachTokenList(tokens, source);
+    seekToken(at);
+    setSyntaxErrorSink(collectError, parse);
+
+    for (;;) {
+        size_t here = currentTokenIndex();
+        while (j < parse->segmentCount
+               && (parse->segments[j].first < dirtyEnd
+                   || (long long)parse->segments[j].first + shift < (long long)here))
+            j++;
+        if (j < parse->segmentCount && (long long)parse->segments[j].first + shift == (long long)here
+            && startState(parse->segments[j].kind) == state) {
+            //same tokens ahead in the same state: the rest is unchanged
+            synced = 1;
+            break;
+        }
+
+        int kind;
+        if (state == IN_FUNCTIONS) {
+            if (!check(R_WALA))
+                break;
+            kind = SEG_FUNC_HEAD;
+        } else {
+            kind = atBlockEnd() ? SEG_FUNC_TAIL : SEG_STATEMENT;
+        }
+
+        size_t diagnostic = parse->freshDiagnosticCount;
+        if (kind == SEG_FUNC_HEAD) {
+            parseFunctionHead();
+            state = IN_BODY;
+        } else if (kind == SEG_STATEMENT) {
+            parseStatement();
+        } else {
+            parseFunctionTail();
+            state = IN_FUNCTIONS;
+        }
+
+        parse->freshSegments = grow(parse->freshSegments, &parse->freshSegmentCapacity,
+                                    parse->freshSegmentCount + 1, sizeof(ParseSegment));
+        ParseSegment *segment = &parse->freshSegments[parse->freshSegmentCount++];
+        segment->first = here;
+        segment->end = currentTokenIndex();
+        segment->diagnostic = diagnostic;
+        segment->diagnostics = parse->freshDiagnosticCount - diagnostic;
+        segment->kind = kind;
+    }
+
+    parse->parsedTokens = currentTokenIndex() - at;
+    if (!synced)
+        parse->stop = currentTokenIndex();
+    setSyntaxErrorSink(NULL, NULL);
+    freeTokens();
+    *resume = synced ? j : parse->segmentCount;
+    return synced;
+}
+
+//put the fresh segments in place of old segments [from, to), shifting the
+//token indices of the ones after them
+static void splice(IncParse *parse, size_t from, size_t to, long long shift) {
+    size_t diagFrom = from < parse->segmentCount ? parse->segments[from].diagnostic : parse->diagnosticCount;
+    size_t diagTo = to < parse->segmentCount ? parse->segments[to].diagnostic : parse->diagnosticCount;
+    size_t segTail = parse->segmentCount - to;
+    size_t diagTail = parse->diagnosticCount - diagTo;
+    size_t segCount = from + parse->freshSegmentCount + segTail;
+    size_t diagCount = diagFrom + parse->freshDiagnosticCount + diagTail;
+    long long diagShift = (long long)parse->freshDiagnosticCount - (long long)(diagTo - diagFrom);
+
+    parse->segments = grow(parse->segments, &parse->segmentCapacity, segCount, sizeof(ParseSegment));
+    parse->diagnostics = grow(parse->diagnostics, &parse->diagnosticCapacity, diagCount, sizeof(ParseDiagnostic));
+
+    parse->shifted = segTail + diagTail;
+    size_t segAt = from + parse->freshSegmentCount;
+    size_t diagAt = diagFrom + parse->freshDiagnosticCount;
+    //no copies of nothing: the arrays may still be NULL
+    if (segTail)
+        memmove(parse->segments + segAt, parse->segments + to, segTail * sizeof(ParseSegment));
+    if (diagTail)
+        memmove(parse->diagnostics + diagAt, parse->diagnostics + diagTo, diagTail * sizeof(ParseDiagnostic));
+
+    for (size_t i = 0; i < parse->freshSegmentCount; i++) {
+        parse->segments[from + i] = parse->freshSegments[i];
+        parse->segments[from + i].diagnostic += diagFrom;
+    }
+    if (parse->freshDiagnosticCount)
+        memcpy(parse->diagnostics + diagFrom, parse->freshDiagnostics,
+               parse->freshDiagnosticCount * sizeof(ParseDiagnostic));
+
+    if (shift != 0 || diagShift != 0) {
+        for (size_t i = segAt; i < segCount; i++) {
+            parse->segments[i].first = (size_t)((long long)parse->segments[i].first + shift);
+            parse->segments[i].end = (size_t)((long long)parse->segments[i].end + shift);
+            parse->segments[i].diagnostic = (size_t)((long long)parse->segments[i].diagnostic + diagShift);
+        }
+        for (size_t i = diagAt; i < diagCount; i++)
+            parse->diagnostics[i].token = (size_t)((long long)parse->diagnostics[i].token + shift);
+    }
+
+    parse->segmentCount = segCount;
+    parse->diagnosticCount = diagCount;
+}
+
+void incParseFull(IncParse *parse, const TokenList *tokens, const char *source) {
+    size_t resume = 0;
+    parse->segmentCount = 0;
+    parse->diagnosticCount = 0;
+    parseSegments(parse, tokens, source, 0, IN_FUNCTIONS, &resume, 0, 0);
+    splice(parse, 0, 0, 0);
+}
+
+void incReparse(IncParse *parse, const TokenList *tokens, const char *source, const RelexResult *edit) {
+    size_t dirtyFirst = edit->first;
+    size_t dirtyEnd = edit->first + edit->oldCount;
+    long long shift = (long long)edit->newCount - (long long)edit->oldCount;
+
+    //first segment that looked at a replaced token (ends at or after it)
+    size_t low = 0, high = parse->segmentCount;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (parse->segments[mid].end < dirtyFirst)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    size_t from = low;
+
+    if (from == parse->segmentCount && parse->stop < dirtyFirst) {
+        //the edit is in the extra tokens after the program, never looked at
+        parse->parsedTokens = 0;
+        parse->shifted = 0;
+        return;
+    }
+
+    //segments always leave the parser between functions at the end
+    size_t at = from < parse->segmentCount ? parse->segments[from].first : parse->stop;
+    int state = from < parse->segmentCount ? startState(parse->segments[from].kind) : IN_FUNCTIONS;
+    if (from == 0 || at > dirtyFirst) {
+        //replaced tokens in front of the first segment (only comments were
+        //there, maybe code now): start over from the top, between functions.
+        //at is an old index and must not be past the edit to be seeked to
+        from = 0;
+        at = 0;
+        state = IN_FUNCTIONS;
+    }
+    size_t oldStop = parse->stop;
+    size_t to = from;
+    if (parseSegments(parse, tokens, source, at, state, &to, dirtyEnd, shift))
+        parse->stop = (size_t)((long long)oldStop + shift);
+    splice(parse, from, to, shift);
+}
+
+void incParsePrint(const IncParse *parse, const TokenList *tokens, const char *source, FILE *file) {
+    Arena lexemes;
+    arenaInit(&lexemes, 0);
+
+    //the end of input is on the line of the last token that is not a comment
+    int lastLine = 0;
+    for (size_t i = tokens->count; i > 0; i--) {
+        if (tokens->tokens[i - 1].category != CAT_COMMENT) {
+            lastLine = (int)tokens->tokens[i - 1].lineNumber;
+            break;
+        }
+    }
+
+    fprintf(file, "Parsing Program...\n");
+    size_t shown = parse->diagnosticCount < PARSER_MAX_DIAGNOSTICS ? parse->diagnosticCount : PARSER_MAX_DIAGNOSTICS;
+    for (size_t i = 0; i < shown; i++) {
+        const ParseDiagnostic *d = &parse->diagnostics[i];
+        if (d->token < tokens->count) {
+            const TokenSpan *t = &tokens->tokens[d->token];
+            printSyntaxError(file, d->message, (int)t->lineNumber,
+                             arenaStrndup(&lexemes, source + t->offset, t->length));
+        } else {
+            //reported once every token had been consumed
+            printSyntaxError(file, d->message, lastLine, NULL);
+        }
+    }
+    if (shown < parse->diagnosticCount)
+        printHiddenErrors(file, (int)(parse->diagnosticCount - shown));
+    if (parse->stop < tokens->count)
+        fprintf(file, "Warning: Extra tokens after program end\n");
+    else
+        fprintf(file, "Syntax Analysis Complete.\n");
+
+    arenaFree(&lexemes);
+}
+
+int incParseErrorCount(const IncParse *parse) {
+    return (int)parse->diagnosticCount;
+}
+
+void incParseFree(IncParse *parse) {
+    free(parse->segments);
+    free(parse->diagnostics);
+    free(parse->freshSegments);
+    free(parse->freshDiagnostics);
+    memset(parse, 0, sizeof(*parse));
+}
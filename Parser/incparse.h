@@ -0,0 +1,80 @@
+#ifndef INCPARSE_H
+#define INCPARSE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "../Lexer/lexer.h"
+#include "../Lexer/relex.h"
+
+//Incremental re-parsing on top of relex(), for editor-style use.
+//
+//A program is kept as a run of segments that tile the token list: the head
+//of a function (wala ugat ( ) {), one top-level statement of its body, or
+//the closing brace. Parsing a segment only looks at its own tokens plus the
+//token it stops at, and starts in one of two states (between functions or
+//inside a body), so after an edit only the segments that saw a replaced
+//token are parsed again. Re-parsing stops as soon as a new segment starts,
+//past the edit, at the same (shifted) token and state as an old one; the
+//old segments from there on are kept.
+//
+//Diagnostics are stored per segment as (token index, message) so line
+//numbers and lexemes come from the current token list when printed.
+//
+//What an edit costs: the top-level statement around it is parsed again
+//whole, however deep in it the edit is, so an edit inside a long loop
+//body re-parses the loop. And as with relex(), the segments and
+//diagnostics after the edit hold absolute token indices, so they are
+//moved and shifted, a pass over everything behind the edit that is cheap
+//next to parsing but grows with the file; shifted reports it.
+
+typedef enum {
+    SEG_FUNC_HEAD,   // wala ugat ( ) {       starts between functions
+    SEG_STATEMENT,   // one statement         starts inside a body
+    SEG_FUNC_TAIL    // }                     starts inside a body
+} SegmentKind;
+
+typedef struct {
+    size_t first;        // token index the segment starts at
+    size_t end;          // token index it stopped at (looked at, not taken)
+    size_t diagnostic;   // index of its first diagnostic
+    size_t diagnostics;  // how many it has
+    int kind;            // SegmentKind
+} ParseSegment;
+
+typedef struct {
+    size_t token;         // token index the error was reported at
+    const char *message;  // static text from the parser
+} ParseDiagnostic;
+
+typedef struct {
+    ParseSegment *segments;
+    size_t segmentCount, segmentCapacity;
+    ParseDiagnostic *diagnostics;
+    size_t diagnosticCount, diagnosticCapacity;
+    size_t stop;          // token index parsing ended at
+    size_t parsedTokens;  // tokens the last (re)parse went over
+    size_t shifted;       // segments and diagnostics after them it moved
+    // scratch for the segments being parsed again
+    ParseSegment *freshSegments;
+    size_t freshSegmentCount, freshSegmentCapacity;
+    ParseDiagnostic *freshDiagnostics;
+    size_t freshDiagnosticCount, freshDiagnosticCapacity;
+} IncParse;
+
+void incParseInit(IncParse *parse);
+
+//parse the whole token list from scratch
+void incParseFull(IncParse *parse, const TokenList *tokens, const char *source);
+
+//bring parse up to date after relex() changed tokens as described by edit
+//(source is the text after the edit)
+void incReparse(IncParse *parse, const TokenList *tokens, const char *source, const RelexResult *edit);
+
+//same output as parseProgram() would give for the current text
+void incParsePrint(const IncParse *parse, const TokenList *tokens, const char *source, FILE *file);
+
+int incParseErrorCount(const IncParse *parse);
+
+void incParseFree(IncParse *parse);
+
+#endif
@@ -1,7 +1,184 @@
+#include <pthread.h>
 #include "parser.h"
+#include "batch.h"
+#include "server.h"
+#include "semantic.h"
+#include "../Lexer/source.h"
+
+typedef struct {
+    const SourceBuffer *src;
+    TokenRing *ring;
+} PipeLexer;
+
+//lexer thread of --pipe: every token into the ring, then close it
+static void *lexIntoRing(void *arg) {
+    PipeLexer *pipe = arg;
+    LexerCtx lexer;
+    TokenSpan tok;
+    lexer_init(&lexer, pipe->src->data, pipe->src->length);
+    while (lexer_next(&lexer, &tok)) {
+        if (!tokRingPush(pipe->ring, &tok))
+            break; //parser is done early
+    }
+    tokRingClose(pipe->ring);
+    return NULL;
+}
+
+static int printing = 0, checking = 0;
+
+//after a parse: --check the tree if it parsed cleanly, --ast print it,
+//then let it go while its text is still there
+static void finishTree(Ast *tree) {
+    if (!tree)
+        return;
+    if (checking && syntaxErrorCount() == 0) {
+        SemanticCtx semantic;
+        semanticInit(&semantic);
+        semanticCheck(&semantic, tree, stdout);
+        semanticFree(&semantic);
+    }
+    if (printing)
+        astPrint(tree, stdout);
+    astFree(tree);
+}
+
+//parse with the lexer on a second thread feeding a TokenRing
+static int parsePipelined(const SourceBuffer *src, Ast *tree) {
+    TokenRing ring;
+    PipeLexer pipe = { src, &ring };
+    pthread_t lexerThread;
+
+    if (tokRingInit(&ring, TOKRING_DEFAULT_SLOTS) != 0) {
+        printf("Error: out of memory\n");
+        return 1;
+    }
+    if (pthread_create(&lexerThread, NULL, lexIntoRing, &pipe) != 0) {
+        printf("Cannot start the lexer thread\n");
+        tokRingFree(&ring);
+        return 1;
+    }
+    attachRing(&ring, src->data);
+    parseProgram();
+    tokRingAbandon(&ring); //unblocks the lexer if the parse stopped early
+    pthread_join(lexerThread, NULL);
+    finishTree(tree);
+    freeTokens();
+    tokRingFree(&ring);
+    return 0;
+}
+
+//parser file.usb lexes the file in-process, parser file.tok reads a binary
+//token stream, no argument reads the symbol table the lexer wrote.
+//parser --batch [--jobs N] files/folders... lexes and parses many files at once,
+//parser --pipe file.usb lexes on a second thread while parsing,
+//parser --ast file prints the syntax tree after the messages,
+//parser --check file also checks names and types once it parses cleanly,
+//files are parsed with an explicit stack, so no nesting overflows the C
+//stack (--nesting N: at most N nested braces and parentheses), parser
+//--recursive file parses with the recursive rules instead (--stack is the
+//default, still accepted),
+//parser --serve socket stays up answering lex/parse requests and
+//parser --client socket [--symbols] files... sends files to such a server
+int main(int argc, char *argv[]) {
+    int pipelined = 0;
+    Ast ast;
+    Ast *tree = NULL;
+    if (argc > 2 && strcmp(argv[1], "--serve") == 0)
+        return runServer(argv[2]);
+    if (argc > 2 && strcmp(argv[1], "--client") == 0) {
+        const char *socketPath = argv[2];
+        int symbols = 0;
+        argv += 3;
+        argc -= 3;
+        if (argc > 0 && strcmp(argv[0], "--symbols") == 0) {
+            symbols = 1;
+            argv++;
+            argc--;
+        }
+        return runClient(socketPath, argv, argc, symbols);
+    }
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        int jobs = 0;
+        argv += 2;
+        argc -= 2;
+        if (argc > 1 && strcmp(argv[0], "--jobs") == 0) {
+            jobs = atoi(argv[1]);
+            argv += 2;
+            argc -= 2;
+        }
+        return runBatch(argv, argc, jobs);
+    }
+
+    setParserStackLimit(PARSER_NESTING_LIMIT);
+    for (; argc > 1 && strncmp(argv[1], "--", 2) == 0; argv++, argc--) {
+        if (strcmp(argv[1], "--ast") == 0) {
+            printing = 1;
+        } else if (strcmp(argv[1], "--check") == 0) {
+            checking = 1;
+        } else if (strcmp(argv[1], "--pipe") == 0) {
+            pipelined = 1;
+        } else if (strcmp(argv[1], "--stack") == 0) {
+            setParserStackLimit(PARSER_NESTING_LIMIT);
+        } else if (strcmp(argv[1], "--recursive") == 0) {
+            setParserStackLimit(0);
+        } else if (strcmp(argv[1], "--nesting") == 0 && argc > 2) {
+            setParserStackLimit((size_t)strtoul(argv[2], NULL, 10));
+            argv++;
+            argc--;
+        } else {
+            printf("Unknown option %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    if (printing || checking) {
+        astInit(&ast);
+        tree = &ast;
+        setParserAst(tree);
+    }
+
+    const char *dot = argc > 1 ? strrchr(argv[1], '.') : NULL;
+    if (dot && strcmp(dot, ".tok") == 0) {
+        loadTokensFromBinary(argv[1]);
+        parseProgram();
+        finishTree(tree);
+        freeTokens();
+        return 0;
+    }
+
+    if (argc > 1) {
+        FILE *file = fopen(argv[1], "r");
+        SourceBuffer src;
+        LexerCtx lexer;
+        if (!file) {
+            printf("Cannot open %s\n", argv[1]);
+            return 1;
+        }
+        if (sourceLoad(&src, file) != 0) {
+            printf("Cannot read %s\n", argv[1]);
+            fclose(file);
+            return 1;
+        }
+        fclose(file);
+
+        initialize_lexer();
+        if (pipelined) {
+            int status = parsePipelined(&src, tree);
+            sourceRelease(&src);
+            return status;
+        }
+        lexer_init(&lexer, src.data, src.length);
+        attachLexer(&lexer);
+        parseProgram();
+        finishTree(tree);
+        freeTokens();
+        sourceRelease(&src);
+        return 0;
+    }
 
-int main() {
     loadTokensFromFile("../Lexer/Symbol Table.txt");
     parseProgram();
+    finishTree(tree);
+    freeTokens();
     return 0;
-}
\ No newline at end of file
+}
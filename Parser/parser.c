@@ -1,18 +1,94 @@
 #include "parser.h"
+#include <pthread.h>
 #include "../Lexer/wordhash.h"
+#include "../Lexer/arena.h"
+#include "../Lexer/tokfile.h"
+#include "../Lexer/source.h"
+
+//all parser state is per thread so several files can be parsed at once
+_Thread_local TokenStore tokenStore;
+_Thread_local size_t currentToken = 0;
+
+static _Thread_local Arena lexemeArena; // owns the lexemes of loaded text tokens
+static _Thread_local int lexemeArenaReady = 0;
+
+//token the parser is looking at, the end-of-input token past the last one
+//(on the last token's line)
+static _Thread_local Token current;
+static const Token endOfInput = { CAT_UNKNOWN, U_END_OF_INPUT, NULL, 0 };
+
+//mapping of a binary token stream, tokenStore lexemes point into its pool
+static _Thread_local TokReader binaryTokens;
+
+//when liveSource is set, tokens are pulled straight from the lexer or from
+//a lexer thread's ring instead of tokenStore
+static _Thread_local LexerCtx *liveLexer = NULL;
+static _Thread_local TokenRing *liveRing = NULL;
+static _Thread_local const TokenList *liveList = NULL;
+static _Thread_local size_t listNext = 0;     // liveList index after current
+static _Thread_local size_t listCurrent = 0;  // liveList index of current
+static _Thread_local const char *liveSource = NULL;
+static _Thread_local TokenSpan currentSpan;
+
+//where messages go (NULL = stdout) and how many syntax errors were reported
+static _Thread_local FILE *parserOutput = NULL;
+static _Thread_local int syntaxErrors = 0;
+
+//when set, grammar errors are handed here instead of printed
+static _Thread_local SyntaxErrorSink errorSink = NULL;
+static _Thread_local void *errorSinkContext = NULL;
+
+//syntax errors of the running parse, printed when it ends; past
+//PARSER_MAX_DIAGNOSTICS they are only counted
+typedef struct {
+    const char *message;
+    const char *lexeme;
+    int lineNumber;
+} Diagnostic;
+
+static _Thread_local Diagnostic *diagnostics = NULL;
+static _Thread_local size_t diagnosticCount = 0, diagnosticCapacity = 0;
+
+//set by a reported error until the parser is back in step (end of the
+//statement, function head or tail); errors in between are echoes of it
+static _Thread_local int panicking = 0;
+
+static void freeFrames(void);
+
+static FILE *out(void) {
+    return parserOutput ? parserOutput : stdout;
+}
 
-Token tokens[1000];
-int tokenCount = 0;
-int currentToken = 0;
+void setParserOutput(FILE *file) {
+    parserOutput = file;
+}
 
-// error message
-void syntaxError(const char* message, int lineNumber, const char* lexeme) {
+int syntaxErrorCount(void) {
+    return syntaxErrors;
+}
+
+void setSyntaxErrorSink(SyntaxErrorSink sink, void *context) {
+    errorSink = sink;
+    errorSinkContext = context;
+}
+
+void printSyntaxError(FILE *file, const char* message, int lineNumber, const char* lexeme) {
     if (lineNumber > 0 && lexeme && lexeme[0] != '\0')
-        printf("Syntax Error at line %d: %s near '%s'\n", lineNumber, message, lexeme);
+        fprintf(file, "Syntax Error at line %d: %s near '%s'\n", lineNumber, message, lexeme);
     else if (lineNumber > 0)
-        printf("Syntax Error at line %d: %s\n", lineNumber, message);
+        fprintf(file, "Syntax Error at line %d: %s\n", lineNumber, message);
     else
-        printf("Syntax Error: %s near '%s'\n", message, lexeme ? lexeme : "");
+        fprintf(file, "Syntax Error: %s near '%s'\n", message, lexeme ? lexeme : "");
+}
+
+void printHiddenErrors(FILE *file, int hidden) {
+    fprintf(file, "Too many syntax errors, %d more not shown\n", hidden);
+}
+
+// error message
+void syntaxError(const char* message, int lineNumber, const char* lexeme) {
+    syntaxErrors++;
+    printSyntaxError(out(), message, lineNumber, lexeme);
 }
 
 
@@ -20,245 +96,788 @@ void syntaxError(const char* message, int lineNumber, const char* lexeme) {
 
 // Token Loading
 
+static void *growArray(void *items, size_t capacity, size_t itemSize) {
+    void *grown = realloc(items, capacity * itemSize);
+    if (!grown) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    return grown;
+}
+
+static void tokenStorePush(int kind, const char *lexeme, size_t length, int lineNumber) {
+    TokenStore *store = &tokenStore;
+    if (store->count == store->capacity) {
+        size_t capacity = store->capacity ? store->capacity * 2 : 4096;
+        store->kinds = growArray(store->kinds, capacity, sizeof(*store->kinds));
+        store->lines = growArray(store->lines, capacity, sizeof(*store->lines));
+        store->lexemes = growArray(store->lexemes, capacity, sizeof(*store->lexemes));
+        store->lengths = growArray(store->lengths, capacity, sizeof(*store->lengths));
+        store->capacity = capacity;
+    }
+    store->kinds[store->count] = (uint8_t)kind;
+    store->lines[store->count] = lineNumber;
+    store->lexemes[store->count] = lexeme;
+    store->lengths[store->count] = (uint32_t)length;
+    store->count++;
+}
+
+//first stored token, or the end
+static void startStored(void) {
+    currentToken = 0;
+    if (tokenStore.count > 0) {
+        current.tokenValue = tokenStore.kinds[0];
+        current.lexeme = NULL;
+    } else {
+        current = endOfInput;
+    }
+}
+
+//a reload reuses the arena pages of the previous token list
+static void openLexemeArena(void) {
+    if (!lexemeArenaReady) {
+        arenaInit(&lexemeArena, ARENA_DEFAULT_BLOCK);
+        lexemeArenaReady = 1;
+    }
+    arenaReset(&lexemeArena);
+}
+
+//token names the text loader maps itself; keywords, reserved words and
+//noise words come from the word hash instead
+typedef struct {
+    const char *name;
+    int value;  // NAME_COMMENT for rows that are skipped
+} NameValue;
+
+#define NAME_COMMENT -2
+#define NAME_SLOTS 128  // power of two, well over twice the names
+
+static const NameValue tokenNames[] = {
+    { "L_IDENTIFIER", L_IDENTIFIER },
+    { "L_BILANG_LITERAL", L_BILANG_LITERAL },
+    { "L_LUTANG_LITERAL", L_LUTANG_LITERAL },
+    { "L_KWERDAS_LITERAL", L_KWERDAS_LITERAL },
+    { "L_BULYAN_LITERAL", L_BULYAN_LITERAL },
+    { "L_TITIK_LITERAL", L_TITIK_LITERAL },
+    { "D_LPAREN", D_LPAREN },
+    { "D_RPAREN", D_RPAREN },
+    { "D_LBRACE", D_LBRACE },
+    { "D_RBRACE", D_RBRACE },
+    { "D_LBRACKET", D_LBRACKET },
+    { "D_RBRACKET", D_RBRACKET },
+    { "D_COMMA", D_COMMA },
+    { "D_SEMICOLON", D_SEMICOLON },
+    { "D_COLON", D_COLON },
+    { "D_DOT", D_DOT },
+    { "D_QUOTE", D_QUOTE },
+    { "D_SQUOTE", D_SQUOTE },
+    { "O_PLUS", O_PLUS },
+    { "O_MINUS", O_MINUS },
+    { "O_MULTIPLY", O_MULTIPLY },
+    { "O_DIVIDE", O_DIVIDE },
+    { "O_ASSIGN", O_ASSIGN },
+    { "O_EQUAL", O_EQUAL },
+    { "O_NOT_EQUAL", O_NOT_EQUAL },
+    { "O_LESS", O_LESS },
+    { "O_GREATER", O_GREATER },
+    { "O_LESS_EQ", O_LESS_EQ },
+    { "O_GREATER_EQ", O_GREATER_EQ },
+    { "O_AND", O_AND },
+    { "O_OR", O_OR },
+    { "O_NOT", O_NOT },
+    { "O_MODULO", O_MODULO },
+    { "O_POW", O_POW },
+    { "UNKNOWN_CATEGORY", U_UNKNOWN },  // reported by the grammar, as when lexing live
+    { "C_SINGLE_LINE", NAME_COMMENT },
+    { "C_MULTI_LINE", NAME_COMMENT },
+};
+
+static const NameValue *nameSlots[NAME_SLOTS];
+static pthread_once_t nameSlotsOnce = PTHREAD_ONCE_INIT;
+
+static unsigned nameHash(const char *name, size_t length) {
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    return hash;
+}
+
+static void buildNameSlots(void) {
+    for (size_t i = 0; i < sizeof(tokenNames) / sizeof(tokenNames[0]); i++) {
+        unsigned slot = nameHash(tokenNames[i].name, strlen(tokenNames[i].name));
+        while (nameSlots[slot & (NAME_SLOTS - 1)])
+            slot++;
+        nameSlots[slot & (NAME_SLOTS - 1)] = &tokenNames[i];
+    }
+}
+
+//value for a token name, NULL if the loader does not know it
+static const NameValue *findTokenName(const char *name, size_t length) {
+    unsigned slot = nameHash(name, length);
+    const NameValue *entry;
+    while ((entry = nameSlots[slot & (NAME_SLOTS - 1)]) != NULL) {
+        if (strncmp(entry->name, name, length) == 0 && entry->name[length] == '\0')
+            return entry;
+        slot++;
+    }
+    return NULL;
+}
+
+static int isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static int isNameChar(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+//if the text from start to end (a '\n' or the end of the file) finishes a
+//row "lexeme | TOKEN_NAME | line", split it; the lexeme may span lines
+//(a string or comment with newlines in it), so the row is read from the
+//right and the lexeme is whatever comes before its last " | NAME | line"
+static int splitRow(const char *start, const char *end, const char **lexeme, size_t *lexemeLength,
+                    const char **name, size_t *nameLength, int *lineNum) {
+    const char *p = end;
+    long number = 0, scale = 1;
+
+    while (p > start && isBlank(p[-1]))
+        p--;
+    const char *digits = p;
+    while (p > start && p[-1] >= '0' && p[-1] <= '9') {
+        number += (p[-1] - '0') * scale;
+        scale *= 10;
+        p--;
+    }
+    if (p == digits || digits - p > 9)
+        return 0;
+    while (p > start && isBlank(p[-1]))
+        p--;
+    if (p == start || *--p != '|')
+        return 0;
+    while (p > start && isBlank(p[-1]))
+        p--;
+    const char *nameEnd = p;
+    while (p > start && isNameChar(p[-1]))
+        p--;
+    if (p == nameEnd)
+        return 0;
+    *name = p;
+    *nameLength = (size_t)(nameEnd - p);
+    while (p > start && isBlank(p[-1]))
+        p--;
+    if (p == start || *--p != '|')
+        return 0;
+
+    //the lexeme is padded to its column with spaces
+    while (p > start && isBlank(p[-1]))
+        p--;
+    while (start < p && (isBlank(*start) || *start == '\n'))
+        start++;
+    *lexeme = start;
+    *lexemeLength = (size_t)(p - start);
+    *lineNum = (int)number;
+    return 1;
+}
+
+//fast path for the usual one-line row, where the Lexer's
+//"%-15.*s | %-20s | %d " puts both bars in fixed columns
+static int splitColumns(const char *start, const char *end, const char **lexeme, size_t *lexemeLength,
+                        const char **name, size_t *nameLength, int *lineNum) {
+    const char *p;
+    int number = 0;
+
+    if (end - start < 42 || isBlank(*start) || memcmp(start + 15, " | ", 3) != 0 || memcmp(start + 38, " | ", 3) != 0)
+        return 0;
+    for (p = start + 41; p < end && p - start < 50 && *p >= '0' && *p <= '9'; p++)
+        number = number * 10 + (*p - '0');
+    if (p == start + 41)
+        return 0;
+    while (p < end && isBlank(*p))
+        p++;
+    if (p != end)
+        return 0;
+
+    for (p = start + 18; p < start + 38 && isNameChar(*p); p++)
+        ;
+    *name = start + 18;
+    *nameLength = (size_t)(p - *name);
+    if (*nameLength == 0)
+        return 0;
+    for (; p < start + 38; p++) {
+        if (*p != ' ')
+            return 0;
+    }
+
+    for (p = start + 15; p > start && isBlank(p[-1]); p--)
+        ;
+    *lexeme = start;
+    *lexemeLength = (size_t)(p - start);
+    *lineNum = number;
+    return 1;
+}
+
+static void addTextToken(const char *lexeme, size_t lexemeLength, const char *name, size_t nameLength, int lineNum) {
+    const NameValue *named = findTokenName(name, nameLength);
+    if (named && named->value == NAME_COMMENT)
+        return;
+
+    char *text = arenaStrndup(&lexemeArena, lexeme, lexemeLength);
+    const HashEntry *word = wordLookup(text, lexemeLength);
+    if (word) {
+        tokenStorePush(word->tokenValue, text, lexemeLength, lineNum);
+    } else if (named) {
+        tokenStorePush(named->value, text, lexemeLength, lineNum);
+    } else {
+        syntaxError("Unknown token", lineNum, text); // a name no lexer writes
+        tokenStorePush(U_UNKNOWN, text, lexemeLength, lineNum);
+    }
+}
+
 void loadTokensFromFile(const char *filename) {
-    initialize_table();
+    openLexemeArena();
+    tokenStore.count = 0;
+    currentToken = 0;
+    liveLexer = NULL;
+    liveRing = NULL;
+    liveList = NULL;
+    liveSource = NULL;
+    pthread_once(&nameSlotsOnce, buildNameSlots);
 
     FILE *file = fopen(filename, "r");
+    SourceBuffer table;
     if (!file) {
-        printf("Cannot open %s\n", filename);
+        fprintf(out(), "Cannot open %s\n", filename);
         exit(1);
     }
+    if (sourceLoad(&table, file) != 0) {
+        fprintf(out(), "Cannot read %s\n", filename);
+        exit(1);
+    }
+    fclose(file);
 
-    char line[256];
-    while (fgets(line, sizeof(line), file)) {
-        // skip header lines or empty lines
-        if (strstr(line, "Lexeme") || strstr(line, "Token Name") || strlen(line) < 3)
-            continue;
+    const char *p = table.data;
+    const char *end = table.data + table.length;
 
-        char lexeme[100], tokenName[100];
-        int lineNum;
-        if (sscanf(line, "%s | %s | %d", lexeme, tokenName, &lineNum) == 3) {
+    // skip the header line
+    const char *newline = p < end ? memchr(p, '\n', (size_t)(end - p)) : NULL;
+    if (newline && newline - p >= 6 && strncmp(p, "Lexeme", 6) == 0)
+        p = newline + 1;
 
-            // skip comments
-            if (strcmp(tokenName, "C_SINGLE_LINE") == 0 || strcmp(tokenName, "C_MULTI_LINE") == 0)
-                continue;
+    const char *rowStart = p;
+    while (p < end) {
+        newline = memchr(p, '\n', (size_t)(end - p));
+        const char *lineEnd = newline ? newline : end;
+        const char *lexeme, *name;
+        size_t lexemeLength, nameLength;
+        int lineNum;
 
-            tokens[tokenCount].lexeme = strdup(lexeme);
-            tokens[tokenCount].lineNumber = lineNum;
+        if ((rowStart == p && splitColumns(p, lineEnd, &lexeme, &lexemeLength, &name, &nameLength, &lineNum))
+            || splitRow(rowStart, lineEnd, &lexeme, &lexemeLength, &name, &nameLength, &lineNum)) {
+            // an empty lexeme is one that started with a NUL byte
+            addTextToken(lexeme, lexemeLength, name, nameLength, lineNum);
+            rowStart = lineEnd + 1;
+        } else if (lineEnd - rowStart < 3) {
+            // empty line between rows
+            rowStart = lineEnd + 1;
+        }
+        // otherwise the row goes on past this line
+        p = lineEnd + 1;
+    }
 
-            int category, value;
+    sourceRelease(&table);
+    fprintf(out(), "Loaded %zu tokens from %s\n", tokenStore.count, filename);
+    startStored();
+}
 
-            // look up the lexeme in the hash table
-            if (hashLookup(lexeme, &category, &value)) {
-                tokens[tokenCount].tokenValue = (TokenCategory)value;  // use enum directly
-                tokens[tokenCount].category = category;
-            } else {
-    if (strcmp(tokenName, "L_IDENTIFIER") == 0)
-        tokens[tokenCount].tokenValue = L_IDENTIFIER;
-    else if (strcmp(tokenName, "L_BILANG_LITERAL") == 0)
-        tokens[tokenCount].tokenValue = L_BILANG_LITERAL;
-    else if (strcmp(tokenName, "L_LUTANG_LITERAL") == 0)
-        tokens[tokenCount].tokenValue = L_LUTANG_LITERAL;
-    else if (strcmp(tokenName, "L_KWERDAS_LITERAL") == 0)
-        tokens[tokenCount].tokenValue = L_KWERDAS_LITERAL;
-    else if (strcmp(tokenName, "L_BULYAN_LITERAL") == 0)
-        tokens[tokenCount].tokenValue = L_BULYAN_LITERAL;
-
-    // delimiters
-    else if (strcmp(tokenName, "D_LPAREN") == 0)
-        tokens[tokenCount].tokenValue = D_LPAREN;
-    else if (strcmp(tokenName, "D_RPAREN") == 0)
-        tokens[tokenCount].tokenValue = D_RPAREN;
-    else if (strcmp(tokenName, "D_LBRACE") == 0)
-        tokens[tokenCount].tokenValue = D_LBRACE;
-    else if (strcmp(tokenName, "D_RBRACE") == 0)
-        tokens[tokenCount].tokenValue = D_RBRACE;
-    else if (strcmp(tokenName, "D_LBRACKET") == 0)
-        tokens[tokenCount].tokenValue = D_LBRACKET;
-    else if (strcmp(tokenName, "D_RBRACKET") == 0)
-        tokens[tokenCount].tokenValue = D_RBRACKET;
-    else if (strcmp(tokenName, "D_COMMA") == 0)
-        tokens[tokenCount].tokenValue = D_COMMA;
-    else if (strcmp(tokenName, "D_SEMICOLON") == 0)
-        tokens[tokenCount].tokenValue = D_SEMICOLON;
-    else if (strcmp(tokenName, "D_COLON") == 0)
-        tokens[tokenCount].tokenValue = D_COLON;
-    else if (strcmp(tokenName, "D_DOT") == 0)
-        tokens[tokenCount].tokenValue = D_DOT;
-    else if (strcmp(tokenName, "D_QUOTE") == 0)
-        tokens[tokenCount].tokenValue = D_QUOTE;
-    else if (strcmp(tokenName, "D_SQUOTE") == 0)
-        tokens[tokenCount].tokenValue = D_SQUOTE;
-
-    // operators
-    else if (strcmp(tokenName, "O_PLUS") == 0)
-        tokens[tokenCount].tokenValue = O_PLUS;
-    else if (strcmp(tokenName, "O_MINUS") == 0)
-        tokens[tokenCount].tokenValue = O_MINUS;
-    else if (strcmp(tokenName, "O_MULTIPLY") == 0)
-        tokens[tokenCount].tokenValue = O_MULTIPLY;
-    else if (strcmp(tokenName, "O_DIVIDE") == 0)
-        tokens[tokenCount].tokenValue = O_DIVIDE;
-    else if (strcmp(tokenName, "O_ASSIGN") == 0)
-        tokens[tokenCount].tokenValue = O_ASSIGN;
-    else if (strcmp(tokenName, "O_EQUAL") == 0)
-        tokens[tokenCount].tokenValue = O_EQUAL;
-    else if (strcmp(tokenName, "O_NOT_EQUAL") == 0)
-        tokens[tokenCount].tokenValue = O_NOT_EQUAL;
-    else if (strcmp(tokenName, "O_LESS") == 0)
-        tokens[tokenCount].tokenValue = O_LESS;
-    else if (strcmp(tokenName, "O_GREATER") == 0)
-        tokens[tokenCount].tokenValue = O_GREATER;
-    else if (strcmp(tokenName, "O_LESS_EQ") == 0)
-        tokens[tokenCount].tokenValue = O_LESS_EQ;
-    else if (strcmp(tokenName, "O_GREATER_EQ") == 0)
-        tokens[tokenCount].tokenValue = O_GREATER_EQ;
-    else if (strcmp(tokenName, "O_AND") == 0)
-        tokens[tokenCount].tokenValue = O_AND;
-    else if (strcmp(tokenName, "O_OR") == 0)
-        tokens[tokenCount].tokenValue = O_OR;
-    else if (strcmp(tokenName, "O_NOT") == 0)
-        tokens[tokenCount].tokenValue = O_NOT;
-    else if (strcmp(tokenName, "O_MODULO") == 0)
-        tokens[tokenCount].tokenValue = O_MODULO;   
+void loadTokensFromBinary(const char *filename) {
+    TokenSpan span;
+
+    tokReaderClose(&binaryTokens);
+    tokenStore.count = 0;
+    currentToken = 0;
+    liveLexer = NULL;
+    liveRing = NULL;
+    liveList = NULL;
+    liveSource = NULL;
+
+    int opened = tokReaderOpen(&binaryTokens, filename);
+    if (opened != 0) {
+        if (opened == 2)
+            fprintf(out(), "%s is truncated or damaged\n", filename);
+        else
+            fprintf(out(), "Cannot open %s\n", filename);
+        exit(1);
+    }
 
-    else {
-        syntaxError("Unknown token", 0, lexeme); // token not recognized
+    while (tokReaderNext(&binaryTokens, &span)) {
+        if (span.category == CAT_COMMENT)
+            continue;
+        //a damaged file must not end the input early
+        int kind = span.tokenValue == U_END_OF_INPUT ? U_UNKNOWN : span.tokenValue;
+        tokenStorePush(kind, binaryTokens.pool + span.offset, span.length, (int)span.lineNumber);
+    }
+    if (binaryTokens.damaged) {
+        //parsing the tokens before the damage would pass off a prefix as the program
+        fprintf(out(), "%s is truncated or damaged\n", filename);
+        exit(1);
     }
 
-    tokens[tokenCount].category = CAT_UNKNOWN;
+    fprintf(out(), "Loaded %zu tokens from %s\n", tokenStore.count, filename);
+    startStored();
 }
 
+// Live Lexing
 
-            tokenCount++;
-        }
+//next span from the list, 0 past its end
+static int nextListed(TokenSpan *span) {
+    if (listNext >= liveList->count) {
+        listCurrent = liveList->count;
+        return 0;
     }
+    listCurrent = listNext++;
+    *span = liveList->tokens[listCurrent];
+    return 1;
+}
 
-    fclose(file);
-    printf("Loaded %d tokens from %s\n", tokenCount, filename);
+//next non-comment token from the lexer, lexeme left for later (NULL)
+static void pullToken(void) {
+    do {
+        int got = liveList ? nextListed(&currentSpan)
+                : liveRing ? tokRingPop(liveRing, &currentSpan)
+                : lexer_next(liveLexer, &currentSpan);
+        if (!got) {
+            int line = current.lineNumber;
+            current = endOfInput;
+            current.lineNumber = line;
+            return;
+        }
+    } while (currentSpan.category == CAT_COMMENT);
+
+    current.lexeme = NULL;
+    current.tokenValue = currentSpan.tokenValue;
+    current.lineNumber = currentSpan.lineNumber;
+    current.category = currentSpan.category;
+}
+
+void attachLexer(LexerCtx *lexer) {
+    openLexemeArena();
+    tokenStore.count = 0;
+    currentToken = 0;
+    liveLexer = lexer;
+    liveRing = NULL;
+    liveList = NULL;
+    liveSource = (const char *)lexer->base;
+    current = endOfInput;
+    pullToken();
+}
+
+void attachRing(TokenRing *ring, const char *source) {
+    openLexemeArena();
+    tokenStore.count = 0;
+    currentToken = 0;
+    liveLexer = NULL;
+    liveRing = ring;
+    liveList = NULL;
+    liveSource = source;
+    current = endOfInput;
+    pullToken();
+}
+
+void attachTokenList(const TokenList *list, const char *source) {
+    openLexemeArena();
+    tokenStore.count = 0;
+    currentToken = 0;
+    liveLexer = NULL;
+    liveRing = NULL;
+    liveList = list;
+    liveSource = source;
+    seekToken(0);
+}
+
+void seekToken(size_t index) {
+    listNext = index;
+    panicking = 0;
+    current = endOfInput;
+    pullToken();
+}
+
+size_t currentTokenIndex(void) {
+    return listCurrent;
+}
+
+void freeTokens(void) {
+    if (lexemeArenaReady)
+        arenaFree(&lexemeArena);
+    lexemeArenaReady = 0;
+    tokReaderClose(&binaryTokens);
+    free(tokenStore.kinds);
+    free(tokenStore.lines);
+    free(tokenStore.lexemes);
+    free(tokenStore.lengths);
+    freeFrames();
+    free(diagnostics);
+    diagnostics = NULL;
+    diagnosticCount = diagnosticCapacity = 0;
+    memset(&tokenStore, 0, sizeof(tokenStore));
+    currentToken = 0;
+    liveLexer = NULL;
+    liveRing = NULL;
+    liveList = NULL;
+    liveSource = NULL;
+    current = endOfInput;
 }
 
 
 // Utility Functions
 
+//the grammar only looks at tokenValue; the rest of a stored token is read
+//from its arrays, and live tokens get their lexeme copied out, only when
+//someone asks for them
+static void fillCurrent(void) {
+    if (current.lexeme || current.tokenValue == U_END_OF_INPUT)
+        return;
+    if (liveSource) {
+        current.lexeme = arenaStrndup(&lexemeArena, liveSource + currentSpan.offset, currentSpan.length);
+    } else {
+        current.category = (TokenCategory)TOKEN_CATEGORY(tokenStore.kinds[currentToken]);
+        current.lineNumber = tokenStore.lines[currentToken];
+        current.lexeme = (char *)tokenStore.lexemes[currentToken];
+    }
+}
+
+//syntax error reported at the current token
+static void reportHere(const char *message) {
+    syntaxErrors++;
+    if (errorSink) {
+        errorSink(errorSinkContext, currentTokenIndex(), message);
+        return;
+    }
+    if (diagnosticCount == PARSER_MAX_DIAGNOSTICS)
+        return;
+    if (diagnosticCount == diagnosticCapacity) {
+        diagnosticCapacity = diagnosticCapacity ? diagnosticCapacity * 2 : 16;
+        diagnostics = growArray(diagnostics, diagnosticCapacity, sizeof(Diagnostic));
+    }
+    fillCurrent();
+    diagnostics[diagnosticCount].message = message;
+    diagnostics[diagnosticCount].lexeme = current.lexeme;
+    diagnostics[diagnosticCount].lineNumber = current.lineNumber;
+    diagnosticCount++;
+}
+
+//grammar error: reported unless the parser is still recovering from one
+static void syntaxErrorHere(const char *message) {
+    if (panicking)
+        return;
+    panicking = 1;
+    reportHere(message);
+}
+
+static void printDiagnostics(void) {
+    for (size_t i = 0; i < diagnosticCount; i++)
+        printSyntaxError(out(), diagnostics[i].message, diagnostics[i].lineNumber, diagnostics[i].lexeme);
+    if (!errorSink && (size_t)syntaxErrors > diagnosticCount)
+        printHiddenErrors(out(), syntaxErrors - (int)diagnosticCount);
+}
+
+void advance(void) {
+    if (current.tokenValue == U_END_OF_INPUT)
+        return;
+    currentToken++;
+    if (liveSource) {
+        pullToken();
+    } else if (currentToken < tokenStore.count) {
+        current.tokenValue = tokenStore.kinds[currentToken];
+        current.lexeme = NULL;
+    } else {
+        current = endOfInput;
+        current.lineNumber = tokenStore.lines[tokenStore.count - 1];
+    }
+}
+
 Token getCurrentToken() {
-    return tokens[currentToken];
+    fillCurrent();
+    return current;
 }
 
 int check(int expected) {
-    int result = tokens[currentToken].tokenValue == expected;
+    int result = current.tokenValue == expected;
     return result;
 }
 
 
 void match(int expected) {
-    if (tokens[currentToken].tokenValue == expected) {
-        currentToken++;
+    if (current.tokenValue == expected) {
+        if (expected == D_SEMICOLON || expected == D_RBRACE)
+            panicking = 0; //a statement or block closed: back in step
+        advance();
     } else {
-        syntaxError("Mismatched expected token", tokens[currentToken].lineNumber, tokens[currentToken].lexeme);
+        syntaxErrorHere("Mismatched expected token");
     }
 }
 
-// Grammar Implementation (Bottom-Up Order)
+// Token sets of the grammar: for every kind, the sets it belongs to, so a
+// membership test is one load and an AND instead of a chain of check()s
+enum {
+    SET_OPERAND    = 1 << 0,  // identifier or literal, a factor on its own
+    SET_EXPRESSION = 1 << 1,  // FIRST(expression): an operand, '(' or '!'
+    SET_DATA_TYPE  = 1 << 2,  // FIRST(declaration)
+    SET_BLOCK_END  = 1 << 3,  // ends a statement list: } wala, end of input
+    SET_SYNC       = 1 << 4   // a statement in error is skipped up to these:
+                              // block ends, ; and statement keywords
+};
+
+static const uint8_t kindSets[TOKEN_KINDS] = {
+    [L_IDENTIFIER]      = SET_OPERAND | SET_EXPRESSION,
+    [L_BILANG_LITERAL]  = SET_OPERAND | SET_EXPRESSION,
+    [L_LUTANG_LITERAL]  = SET_OPERAND | SET_EXPRESSION,
+    [L_KWERDAS_LITERAL] = SET_OPERAND | SET_EXPRESSION,
+    [L_BULYAN_LITERAL]  = SET_OPERAND | SET_EXPRESSION,
+    [D_LPAREN]          = SET_EXPRESSION,
+    [O_NOT]             = SET_EXPRESSION,
+    [R_BILANG]          = SET_DATA_TYPE | SET_SYNC,
+    [R_LUTANG]          = SET_DATA_TYPE | SET_SYNC,
+    [R_BULYAN]          = SET_DATA_TYPE | SET_SYNC,
+    [R_KWERDAS]         = SET_DATA_TYPE | SET_SYNC,
+    [K_KUNG]            = SET_SYNC,
+    [K_PARA]            = SET_SYNC,
+    [K_HABANG]          = SET_SYNC,
+    [K_GAWIN]           = SET_SYNC,
+    [D_SEMICOLON]       = SET_SYNC,
+    [D_RBRACE]          = SET_BLOCK_END | SET_SYNC,
+    [R_WALA]            = SET_BLOCK_END | SET_SYNC,
+    [U_END_OF_INPUT]    = SET_BLOCK_END | SET_SYNC,
+};
+
+// Grammar rules by number, for tables and for the explicit-stack driver;
+// the statement forms come first
+typedef enum {
+    RULE_NONE,
+    RULE_DECLARATION,
+    RULE_ASSIGNMENT,
+    RULE_KUNG,
+    RULE_PARA,
+    RULE_HABANG,
+    RULE_GAWIN,
+    RULE_DECLARATOR,
+    RULE_BLOCK,       // statement list, in braces or not
+    RULE_FUNCTIONS,
+    RULE_EXPRESSION
+} Rule;
+
+// Statement forms by their first token (FIRST(statement) is every kind
+// with a form); a new form is one more entry here and in statementRules
+static const uint8_t statementForms[TOKEN_KINDS] = {
+    [R_BILANG]     = RULE_DECLARATION,
+    [R_LUTANG]     = RULE_DECLARATION,
+    [R_BULYAN]     = RULE_DECLARATION,
+    [R_KWERDAS]    = RULE_DECLARATION,
+    [L_IDENTIFIER] = RULE_ASSIGNMENT,
+    [K_KUNG]       = RULE_KUNG,
+    [K_PARA]       = RULE_PARA,
+    [K_HABANG]     = RULE_HABANG,
+    [K_GAWIN]      = RULE_GAWIN,
+};
+
+static AstIndex (*const statementRules[])(void) = {
+    [RULE_DECLARATION] = parseDeclarationStatement,
+    [RULE_ASSIGNMENT]  = parseAssignmentStatement,
+    [RULE_KUNG]        = parseConditionalStatement,
+    [RULE_PARA]        = parseLoopStatement,
+    [RULE_HABANG]      = parseLoopStatement,
+    [RULE_GAWIN]       = parseLoopStatement,
+};
+
+static int inSet(unsigned set) {
+    return kindSets[current.tokenValue] & set;
+}
 
-void parseRelOp() {
-    if (check(O_EQUAL) || check(O_NOT_EQUAL) || check(O_GREATER) || check(O_LESS) ||
-        check(O_GREATER_EQ) || check(O_LESS_EQ))
-        currentToken++;
-    else {
-        syntaxError("Expected relational operator", tokens[currentToken].lineNumber, tokens[currentToken].lexeme);
+// Expression operators by binding power. An infix operator takes as its
+// right operand everything up to the next operator whose left power is not
+// above its right power: left < right associates to the left, left > right
+// to the right. Kinds with left 0 end an expression
+typedef struct {
+    uint8_t left, right;
+} BindingPower;
+
+static const BindingPower infixPowers[TOKEN_KINDS] = {
+    [O_OR]         = { 1, 2 },
+    [O_AND]        = { 3, 4 },
+    [O_EQUAL]      = { 5, 6 },
+    [O_NOT_EQUAL]  = { 5, 6 },
+    [O_LESS]       = { 7, 8 },
+    [O_GREATER]    = { 7, 8 },
+    [O_LESS_EQ]    = { 7, 8 },
+    [O_GREATER_EQ] = { 7, 8 },
+    [O_PLUS]       = { 9, 10 },
+    [O_MINUS]      = { 9, 10 },
+    [O_MULTIPLY]   = { 11, 12 },
+    [O_DIVIDE]     = { 11, 12 },
+    [O_MODULO]     = { 11, 12 },
+    [O_POW]        = { 14, 13 },
+};
+
+#define PREFIX_POWER 15  // ! binds tighter than any infix operator
+
+
+// Syntax Tree
+
+static _Thread_local Ast *parserAst = NULL; // tree being built, NULL = validate only
+
+void setParserAst(Ast *ast) {
+    parserAst = ast;
+}
+
+static int currentLine(void) {
+    if (liveSource || current.tokenValue == U_END_OF_INPUT)
+        return current.lineNumber;
+    return tokenStore.lines[currentToken];
+}
+
+//node for a rule starting at the current token
+static AstIndex newNode(AstKind kind, int token) {
+    if (!parserAst)
+        return AST_NONE;
+    return astNew(parserAst, kind, token, (uint32_t)currentLine());
+}
+
+//node for the current token itself, text = its lexeme
+static AstIndex newLeaf(AstKind kind) {
+    if (!parserAst)
+        return AST_NONE;
+    if (liveSource)
+        return astLeaf(parserAst, kind, current.tokenValue, (uint32_t)currentSpan.lineNumber,
+                      liveSource + currentSpan.offset, (uint32_t)currentSpan.length);
+    return astLeaf(parserAst, kind, current.tokenValue, (uint32_t)tokenStore.lines[currentToken],
+                  tokenStore.lexemes[currentToken], tokenStore.lengths[currentToken]);
+}
+
+static void addChild(AstChildren *children, AstIndex child) {
+    if (parserAst)
+        astAdd(parserAst, children, child);
+}
+
+static void setFlag(AstIndex node, unsigned flag) {
+    if (node != AST_NONE)
+        parserAst->nodes[node].flags |= (uint8_t)flag;
+}
+
+//match() that also returns a leaf for the matched token
+static AstIndex matchLeaf(int expected, AstKind kind) {
+    if (current.tokenValue != expected) {
+        syntaxErrorHere("Mismatched expected token");
+        return AST_NONE;
     }
+    AstIndex leaf = newLeaf(kind);
+    advance();
+    return leaf;
+}
+
+//node with up to two children, built after them
+static AstIndex newParent(AstKind kind, int token, int line, AstIndex first, AstIndex second) {
+    if (!parserAst)
+        return AST_NONE;
+    AstIndex parent = astNew(parserAst, kind, token, (uint32_t)line);
+    AstChildren children = astChildren(parent);
+    astAdd(parserAst, &children, first);
+    astAdd(parserAst, &children, second);
+    return parent;
 }
 
+// Grammar Implementation (Bottom-Up Order)
 
-void parseFactor() {
+AstIndex parseFactor() {
 
-    if (check(L_IDENTIFIER) || check(L_BILANG_LITERAL) || check(L_KWERDAS_LITERAL) || check(L_BULYAN_LITERAL) || check(L_LUTANG_LITERAL))
-        currentToken++;
-    else if (check(D_LPAREN)) {
+    if (inSet(SET_OPERAND)) {
+        AstIndex operand = newLeaf(check(L_IDENTIFIER) ? AST_IDENTIFIER : AST_LITERAL);
+        advance();
+        return operand;
+    } else if (check(D_LPAREN)) {
         match(D_LPAREN);
-        parseExpression();
+        AstIndex inner = parseExpression();
         match(D_RPAREN);
+        return inner;
     } else {
-        syntaxError("Unexpected factor", tokens[currentToken].lineNumber, tokens[currentToken].lexeme);
+        AstIndex error = newNode(AST_ERROR, 0);
+        syntaxErrorHere("Unexpected factor");
+        return error;
     }
 }
 
-// Operator precedence
-void parseTermTail() {
-    while (check(O_MULTIPLY) || check(O_DIVIDE)) {
-        currentToken++;
-        parseFactor();
+// A factor with any prefix operators in front of it
+static AstIndex parseOperand() {
+    if (check(O_NOT)) {
+        int line = currentLine();
+        advance();
+        AstIndex operand = parseExpressionAbove(PREFIX_POWER);
+        return newParent(AST_UNARY, O_NOT, line, operand, AST_NONE);
     }
+    return parseFactor();
 }
 
-void parseTerm() {
-    parseFactor();
-    parseTermTail();
-}
-
-void parseExpressionTail() {
-    while (check(O_PLUS) || check(O_MINUS)) {
-        currentToken++;
-        parseTerm();
+// Precedence climbing: one operand, then every infix operator that binds
+// tighter than minPower folds it with its right operand. Each operand
+// costs the same few calls whatever its precedence level
+AstIndex parseExpressionAbove(int minPower) {
+    AstIndex left = parseOperand();
+    while (infixPowers[current.tokenValue].left > minPower) {
+        int op = current.tokenValue, line = currentLine();
+        advance();
+        AstIndex right = parseExpressionAbove(infixPowers[op].right);
+        left = newParent(AST_BINARY, op, line, left, right);
     }
+    return left;
 }
 
-void parseExpression() {
-    parseTerm();
-    parseExpressionTail();
+AstIndex parseExpression() {
+    return parseExpressionAbove(0);
 }
 
-
-void parseBooleanExpression() {
-    parseExpression();
-    parseRelOp();
-    parseExpression();
+// Conditions take any expression; whether it is a truth value is left to
+// semantic checks
+AstIndex parseBooleanExpression() {
+    return parseExpression();
 }
 
-void parseAssignmentStatement() {
+AstIndex parseAssignmentStatement() {
+    AstIndex statement = newNode(AST_ASSIGNMENT, 0);
+    AstChildren children = astChildren(statement);
+
     // Match the variable
-    match(L_IDENTIFIER);
+    addChild(&children, matchLeaf(L_IDENTIFIER, AST_IDENTIFIER));
 
     // Match '='
     match(O_ASSIGN);
 
     // Only parse an expression if the next token is valid for an expression
-    if (check(L_BILANG_LITERAL) || check(L_LUTANG_LITERAL) || 
-        check(L_KWERDAS_LITERAL) || check(L_BULYAN_LITERAL) || 
-        check(L_IDENTIFIER) || check(D_LPAREN)) 
-    {
-        parseExpression();
+    if (inSet(SET_EXPRESSION)) {
+        addChild(&children, parseExpression());
     } 
     else {
-        syntaxError("Expected expression after '='", tokens[currentToken].lineNumber, tokens[currentToken].lexeme);
+        syntaxErrorHere("Expected expression after '='");
     }
 
     // Match semicolon
     match(D_SEMICOLON);
+    return statement;
 }
 
 
 
-
-void parseDeclarationStatement() {
-    // Match data type
-    if (check(R_BILANG) || check(R_LUTANG) || check(R_BULYAN) || check(R_KWERDAS)) {
-        currentToken++;
-    } else {
-        syntaxError("Expected data type", tokens[currentToken].lineNumber, tokens[currentToken].lexeme);
-    }
-
-    // Match variable name
-    match(L_IDENTIFIER);
+//name [size] = value, up to the comma or semicolon
+static AstIndex parseDeclarator(int reportMissingSize) {
+    AstIndex declarator = newNode(AST_DECLARATOR, 0);
+    AstChildren children = astChildren(declarator);
+    addChild(&children, matchLeaf(L_IDENTIFIER, AST_IDENTIFIER));
 
     // Optional array brackets: array_name[size]
     if (check(D_LBRACKET)) {
         match(D_LBRACKET);
+        setFlag(declarator, AST_ARRAY);
         if (check(L_BILANG_LITERAL)) {
-            match(L_BILANG_LITERAL);  // Array size
-        } else {
-            syntaxError("Expected array size\n", tokens[currentToken].lineNumber, tokens[currentToken].lexeme);
+            addChild(&children, matchLeaf(L_BILANG_LITERAL, AST_LITERAL));  // Array size
+        } else if (reportMissingSize) {
+            syntaxErrorHere("Expected array size\n");
         }
         match(D_RBRACKET);
     }
@@ -267,164 +886,603 @@ void parseDeclarationStatement() {
     if (check(O_ASSIGN)) {
         match(O_ASSIGN);
 
-        if (check(L_BILANG_LITERAL) || check(L_LUTANG_LITERAL) || 
-            check(L_KWERDAS_LITERAL) || check(L_BULYAN_LITERAL) || 
-            check(L_IDENTIFIER) || check(D_LPAREN)) 
-        {
-            parseExpression();
+        if (inSet(SET_EXPRESSION)) {
+            setFlag(declarator, AST_INITIALIZED);
+            addChild(&children, parseExpression());
         } else {
-            syntaxError("Expected expression after '='\n", tokens[currentToken].lineNumber, tokens[currentToken].lexeme);
+            syntaxErrorHere("Expected expression after '='\n");
         }
     }
+    return declarator;
+}
 
-    // Handle multiple declarations separated by commas
-    while (check(D_COMMA)) {
-        match(D_COMMA);
-        match(L_IDENTIFIER);
-
-        // Optional array brackets
-        if (check(D_LBRACKET)) {
-            match(D_LBRACKET);
-            if (check(L_BILANG_LITERAL)) match(L_BILANG_LITERAL);
-            match(D_RBRACKET);
-        }
+AstIndex parseDeclarationStatement() {
+    AstIndex statement = newNode(AST_DECLARATION, current.tokenValue);
+    AstChildren children = astChildren(statement);
 
-        // Optional initialization
-        if (check(O_ASSIGN)) {
-            match(O_ASSIGN);
+    // Match data type
+    if (inSet(SET_DATA_TYPE)) {
+        advance();
+    } else {
+        syntaxErrorHere("Expected data type");
+    }
 
-            if (check(L_BILANG_LITERAL) || check(L_LUTANG_LITERAL) || 
-                check(L_KWERDAS_LITERAL) || check(L_BULYAN_LITERAL) || 
-                check(L_IDENTIFIER) || check(D_LPAREN)) 
-            {
-                parseExpression();
-            } else {
-                syntaxError("Expected expression after '='\n", tokens[currentToken].lineNumber, tokens[currentToken].lexeme);
-            }
-        }
+    // Match variable name, then more declarations separated by commas
+    addChild(&children, parseDeclarator(1));
+    while (check(D_COMMA)) {
+        match(D_COMMA);
+        addChild(&children, parseDeclarator(0));
     }
 
     // Match semicolon at the end
     match(D_SEMICOLON);
+    return statement;
+}
+
+//{ statements }. Without its '{' the block is not entered: the statement
+//is given up and endStatement() skips ahead, so a run of broken heads
+//does not nest
+static AstIndex parseBlock() {
+    if (!check(D_LBRACE)) {
+        syntaxErrorHere("Mismatched expected token");
+        return newNode(AST_BLOCK, 0);
+    }
+    match(D_LBRACE);
+    AstIndex block = parseStatementList();
+    match(D_RBRACE);
+    return block;
 }
 
+AstIndex parseLoopStatement() {
+    AstIndex statement = AST_NONE;
+    AstChildren children = astChildren(AST_NONE);
 
-void parseLoopStatement() {
     if (check(K_PARA)) {
+        statement = newNode(AST_PARA, 0);
+        children = astChildren(statement);
         match(K_PARA);
         match(D_LPAREN);
         
         // First part: initialization (already has semicolon)
-        parseAssignmentStatement();
+        addChild(&children, parseAssignmentStatement());
         
         // Second part: condition
-        parseBooleanExpression();
+        addChild(&children, parseBooleanExpression());
         match(D_SEMICOLON);
         
         // Third part: increment (No semicolon inside for loop header)
-        match(L_IDENTIFIER);
+        AstIndex update = newNode(AST_ASSIGNMENT, 0);
+        AstChildren updateChildren = astChildren(update);
+        addChild(&updateChildren, matchLeaf(L_IDENTIFIER, AST_IDENTIFIER));
         match(O_ASSIGN);
-        parseExpression();
+        addChild(&updateChildren, parseExpression());
+        addChild(&children, update);
         // No semicolon here!
         
         match(D_RPAREN);
-        match(D_LBRACE);
-        parseStatementList();
-        match(D_RBRACE);
+        addChild(&children, parseBlock());
         
     } else if (check(K_HABANG)) {
+        statement = newNode(AST_HABANG, 0);
+        children = astChildren(statement);
         match(K_HABANG);
         match(D_LPAREN);
-        parseBooleanExpression();
+        addChild(&children, parseBooleanExpression());
         match(D_RPAREN);
-        match(D_LBRACE);
-        parseStatementList();
-        match(D_RBRACE);
+        addChild(&children, parseBlock());
         
     } else if (check(K_GAWIN)) {
+        statement = newNode(AST_GAWIN, 0);
+        children = astChildren(statement);
         match(K_GAWIN);
-        match(D_LBRACE);
-        parseStatementList();
-        match(D_RBRACE);
+        addChild(&children, parseBlock());
         match(K_HABANG);
         match(D_LPAREN);
-        parseBooleanExpression();
+        addChild(&children, parseBooleanExpression());
         match(D_RPAREN);
         match(D_SEMICOLON);
     }
+    return statement;
 }
 
-void parseConditionalStatement() {
+AstIndex parseConditionalStatement() {
+    AstIndex statement = newNode(AST_KUNG, 0);
+    AstChildren children = astChildren(statement);
+
     match(K_KUNG);
     match(D_LPAREN);
-    parseBooleanExpression();
+    addChild(&children, parseBooleanExpression());
     match(D_RPAREN);
-    match(D_LBRACE);
-    parseStatementList();
-    match(D_RBRACE);
+    addChild(&children, parseBlock());
 
     if (check(K_KUNDIMAN)) {
+        AstIndex branch = newNode(AST_KUNDIMAN, 0);
+        AstChildren branchChildren = astChildren(branch);
         match(K_KUNDIMAN);
         match(D_LPAREN);
-        parseBooleanExpression();
+        addChild(&branchChildren, parseBooleanExpression());
         match(D_RPAREN);
-        match(D_LBRACE);
-        parseStatementList();
-        match(D_RBRACE);
+        addChild(&branchChildren, parseBlock());
+        addChild(&children, branch);
     }
 
     if (check(K_KUNDI)) {
+        AstIndex branch = newNode(AST_KUNDI, 0);
+        AstChildren branchChildren = astChildren(branch);
         match(K_KUNDI);
-        match(D_LBRACE);
-        parseStatementList();
-        match(D_RBRACE);
+        addChild(&branchChildren, parseBlock());
+        addChild(&children, branch);
     }
+    return statement;
+}
+
+// Panic-mode recovery: after an error the rest of the statement is
+// skipped up to a sync point, a ';' there is taken. Every statement takes
+// its first token (or this skips it), so each one moves the parse on
+static void endStatement(void) {
+    if (!panicking)
+        return;
+    while (!inSet(SET_SYNC))
+        advance();
+    if (check(D_SEMICOLON))
+        advance();
+    panicking = 0;
 }
 
-void parseStatement() {
-    if (check(R_BILANG) || check(R_LUTANG) || check(R_BULYAN) || check(R_KWERDAS))
-        parseDeclarationStatement();
-    else if (check(L_IDENTIFIER))
-        parseAssignmentStatement();
-    else if (check(K_KUNG))
-        parseConditionalStatement();
-    else if (check(K_PARA) || check(K_HABANG) || check(K_GAWIN))
-        parseLoopStatement();
+AstIndex parseStatement() {
+    AstIndex statement = AST_NONE;
+    if (atStatementStart())
+        statement = statementRules[statementForms[current.tokenValue]]();
     else {
-        syntaxError("Unexpected \n", tokens[currentToken].lineNumber, tokens[currentToken].lexeme);
+        syntaxErrorHere("Unexpected token");
     }
+    endStatement();
+    return statement;
+}
+
+int atStatementStart() {
+    return statementForms[current.tokenValue] != RULE_NONE;
+}
+
+int atBlockEnd() {
+    return inSet(SET_BLOCK_END);
 }
 
-void parseStatementList() {
-    while (check(R_BILANG) || check(R_LUTANG) || check(R_BULYAN) || check(R_KWERDAS) ||
-           check(L_IDENTIFIER) || check(K_KUNG) || check(K_PARA) || check(K_HABANG) || check(K_GAWIN)) {
-        parseStatement();
+// stray tokens inside a block are statements in error, not its end
+AstIndex parseStatementList() {
+    AstIndex block = newNode(AST_BLOCK, 0);
+    AstChildren children = astChildren(block);
+    while (!atBlockEnd()) {
+        addChild(&children, parseStatement());
     }
+    return block;
 }
 
-void parseFunction() {
+// wala ugat ( ) {
+AstIndex parseFunctionHead() {
+    AstIndex function = newNode(AST_FUNCTION, 0);
     match(R_WALA);
     match(R_UGAT);
     match(D_LPAREN);
     match(D_RPAREN);
     match(D_LBRACE);
-    parseStatementList();
+    panicking = 0; //the body starts in step either way
+    return function;
+}
+
+// }
+void parseFunctionTail() {
     match(D_RBRACE);
+    panicking = 0;
+}
+
+AstIndex parseFunction() {
+    AstIndex function = parseFunctionHead();
+    AstChildren children = astChildren(function);
+    addChild(&children, parseStatementList());
+    parseFunctionTail();
+    return function;
+}
+
+//node after *last in a sibling chain starting at *first
+static void chainSibling(AstIndex *first, AstIndex *last, AstIndex node) {
+    if (node == AST_NONE)
+        return;
+    if (*last == AST_NONE)
+        *first = node;
+    else
+        parserAst->nodes[*last].nextSibling = node;
+    *last = node;
+}
+
+//functions chained through nextSibling, the first one returned
+AstIndex parseFunctionList() {
+    AstIndex first = AST_NONE, last = AST_NONE;
+    while (check(R_WALA)) {
+        chainSibling(&first, &last, parseFunction());
+    }
+    return first;
+}
+
+// Explicit-stack driver: the same grammar as the rules above, but every
+// rule that would recurse pushes a frame on a heap stack instead, so deep
+// nesting costs heap (sizeof(Frame) per open rule) rather than C stack, and
+// more than stackLimit braces and parentheses open inside each other is
+// reported instead of overflowing. Only brackets that were really there
+// count, so rules opened while recovering never make input "too deep".
+// Every step here mirrors a line of the recursive rule of the same name;
+// a change to one needs the same change to the other
+
+typedef struct {
+    uint8_t rule;           // Rule
+    uint8_t step;           // where in the rule to go on
+    uint8_t flag;           // RULE_BLOCK: statements in { }, RULE_DECLARATOR:
+                            // report a missing array size
+    uint8_t power;          // RULE_EXPRESSION: minPower
+    int op, line;           // RULE_EXPRESSION: operator waiting for its right operand
+    AstIndex node;          // node of the rule (RULE_EXPRESSION: left operand)
+    AstChildren children;   // of node
+    AstChildren inner;      // branch or para update being built
+} Frame;
+
+static _Thread_local size_t stackLimit = 0;   // 0 = recursive rules
+static _Thread_local Frame *frames = NULL;
+static _Thread_local size_t frameCount = 0, frameCapacity = 0;
+static _Thread_local size_t nesting = 0;       // '{' and '(' open on the stack
+static _Thread_local int stackOverflowed = 0;
+
+void setParserStackLimit(size_t nestingLimit) {
+    stackLimit = nestingLimit;
+}
+
+static void freeFrames(void) {
+    free(frames);
+    frames = NULL;
+    frameCount = frameCapacity = 0;
 }
 
-void parseFunctionList() {
-    if (check(R_WALA)) {
-        parseFunction();
-        parseFunctionList();
+//open a rule on top of the stack, at its first step. Frame pointers are
+//stale after a push
+static void pushRule(Rule rule) {
+    if (frameCount == frameCapacity) {
+        frameCapacity = frameCapacity ? frameCapacity * 2 : 64;
+        frames = growArray(frames, frameCapacity, sizeof(Frame));
     }
+    Frame *frame = &frames[frameCount++];
+    memset(frame, 0, sizeof(*frame));
+    frame->rule = (uint8_t)rule;
+    frame->node = AST_NONE;
+    frame->children = astChildren(AST_NONE);
+    frame->inner = astChildren(AST_NONE);
+}
+
+static void pushExpression(int minPower) {
+    pushRule(RULE_EXPRESSION);
+    frames[frameCount - 1].power = (uint8_t)minPower;
+}
+
+//rules with a flag, see Frame
+static void pushFlagged(Rule rule, int flag) {
+    pushRule(rule);
+    frames[frameCount - 1].flag = (uint8_t)flag;
+}
+
+//the current '{' or '(' is about to be entered; 0 if that is one more than
+//stackLimit, and the parse ends here
+static int openBracket(void) {
+    if (nesting == stackLimit) {
+        if (!stackOverflowed)
+            reportHere("Nesting too deep"); //even while recovering: the parse ends here
+        stackOverflowed = 1;
+        return 0;
+    }
+    nesting++;
+    return 1;
+}
+
+//one step of the rule on top of the stack; returns the rule's node once
+//it is done (and popped), AST_NONE otherwise with *done left 0
+static AstIndex stepRule(AstIndex result, int *done) {
+    Frame *f = &frames[frameCount - 1];
+    int op;
+
+#define CALL(next, push) do { f->step = (next); push; return AST_NONE; } while (0)
+#define RETURN(node) do { AstIndex returned_ = (node); frameCount--; *done = 1; return returned_; } while (0)
+
+    switch (f->rule) {
+    case RULE_FUNCTIONS:
+        // node = first function, children.last = last, inner.parent = current
+        if (f->step == 1) {
+            AstChildren body = astChildren(f->inner.parent);
+            addChild(&body, result);
+            parseFunctionTail();
+            chainSibling(&f->node, &f->children.last, f->inner.parent);
+        }
+        if (!check(R_WALA))
+            RETURN(f->node);
+        f->inner.parent = parseFunctionHead();
+        CALL(1, pushFlagged(RULE_BLOCK, 0));
+
+    case RULE_BLOCK:
+        switch (f->step) {
+        case 0:
+            if (f->flag && !check(D_LBRACE)) {
+                syntaxErrorHere("Mismatched expected token");
+                RETURN(newNode(AST_BLOCK, 0));
+            }
+            if (f->flag) {
+                if (!openBracket())
+                    return AST_NONE;
+                match(D_LBRACE);
+            }
+            f->node = newNode(AST_BLOCK, 0);
+            f->children = astChildren(f->node);
+            break;
+        case 1:
+            addChild(&f->children, result);
+            endStatement();
+            break;
+        }
+        while (!atBlockEnd() && !atStatementStart())
+            parseStatement(); //a stray token: reported and skipped, nothing nests
+        if (!atBlockEnd())
+            CALL(1, pushRule((Rule)statementForms[current.tokenValue]));
+        if (f->flag) {
+            match(D_RBRACE);
+            nesting--;
+        }
+        RETURN(f->node);
+
+    case RULE_DECLARATION:
+        if (f->step == 0) {
+            f->node = newNode(AST_DECLARATION, current.tokenValue);
+            f->children = astChildren(f->node);
+            if (inSet(SET_DATA_TYPE)) {
+                advance();
+            } else {
+                syntaxErrorHere("Expected data type");
+            }
+            CALL(1, pushFlagged(RULE_DECLARATOR, 1));
+        }
+        addChild(&f->children, result);
+        if (check(D_COMMA)) {
+            match(D_COMMA);
+            CALL(1, pushFlagged(RULE_DECLARATOR, 0));
+        }
+        match(D_SEMICOLON);
+        RETURN(f->node);
+
+    case RULE_DECLARATOR:
+        if (f->step == 1) {
+            addChild(&f->children, result);
+            RETURN(f->node);
+        }
+        f->node = newNode(AST_DECLARATOR, 0);
+        f->children = astChildren(f->node);
+        addChild(&f->children, matchLeaf(L_IDENTIFIER, AST_IDENTIFIER));
+        if (check(D_LBRACKET)) {
+            match(D_LBRACKET);
+            setFlag(f->node, AST_ARRAY);
+            if (check(L_BILANG_LITERAL)) {
+                addChild(&f->children, matchLeaf(L_BILANG_LITERAL, AST_LITERAL));
+            } else if (f->flag) {
+                syntaxErrorHere("Expected array size\n");
+            }
+            match(D_RBRACKET);
+        }
+        if (check(O_ASSIGN)) {
+            match(O_ASSIGN);
+            if (inSet(SET_EXPRESSION)) {
+                setFlag(f->node, AST_INITIALIZED);
+                CALL(1, pushExpression(0));
+            }
+            syntaxErrorHere("Expected expression after '='\n");
+        }
+        RETURN(f->node);
+
+    case RULE_ASSIGNMENT:
+        if (f->step == 0) {
+            f->node = newNode(AST_ASSIGNMENT, 0);
+            f->children = astChildren(f->node);
+            addChild(&f->children, matchLeaf(L_IDENTIFIER, AST_IDENTIFIER));
+            match(O_ASSIGN);
+            if (inSet(SET_EXPRESSION))
+                CALL(1, pushExpression(0));
+            syntaxErrorHere("Expected expression after '='");
+        } else {
+            addChild(&f->children, result);
+        }
+        match(D_SEMICOLON);
+        RETURN(f->node);
+
+    case RULE_KUNG:
+        switch (f->step) {
+        case 0:
+            f->node = newNode(AST_KUNG, 0);
+            f->children = astChildren(f->node);
+            match(K_KUNG);
+            match(D_LPAREN);
+            CALL(1, pushExpression(0));
+        case 1:
+            addChild(&f->children, result);
+            match(D_RPAREN);
+            CALL(2, pushFlagged(RULE_BLOCK, 1));
+        case 2:
+            addChild(&f->children, result);
+            if (check(K_KUNDIMAN)) {
+                f->inner = astChildren(newNode(AST_KUNDIMAN, 0));
+                match(K_KUNDIMAN);
+                match(D_LPAREN);
+                CALL(3, pushExpression(0));
+            }
+            break;
+        case 3:
+            addChild(&f->inner, result);
+            match(D_RPAREN);
+            CALL(4, pushFlagged(RULE_BLOCK, 1));
+        case 4:
+            addChild(&f->inner, result);
+            addChild(&f->children, f->inner.parent);
+            break;
+        case 5:
+            addChild(&f->inner, result);
+            addChild(&f->children, f->inner.parent);
+            RETURN(f->node);
+        }
+        if (check(K_KUNDI)) {
+            f->inner = astChildren(newNode(AST_KUNDI, 0));
+            match(K_KUNDI);
+            CALL(5, pushFlagged(RULE_BLOCK, 1));
+        }
+        RETURN(f->node);
+
+    case RULE_PARA:
+        switch (f->step) {
+        case 0:
+            f->node = newNode(AST_PARA, 0);
+            f->children = astChildren(f->node);
+            match(K_PARA);
+            match(D_LPAREN);
+            CALL(1, pushRule(RULE_ASSIGNMENT));
+        case 1:
+            addChild(&f->children, result);
+            CALL(2, pushExpression(0));
+        case 2:
+            addChild(&f->children, result);
+            match(D_SEMICOLON);
+            f->inner = astChildren(newNode(AST_ASSIGNMENT, 0));
+            addChild(&f->inner, matchLeaf(L_IDENTIFIER, AST_IDENTIFIER));
+            match(O_ASSIGN);
+            CALL(3, pushExpression(0));
+        case 3:
+            addChild(&f->inner, result);
+            addChild(&f->children, f->inner.parent);
+            match(D_RPAREN);
+            CALL(4, pushFlagged(RULE_BLOCK, 1));
+        }
+        addChild(&f->children, result);
+        RETURN(f->node);
+
+    case RULE_HABANG:
+        switch (f->step) {
+        case 0:
+            f->node = newNode(AST_HABANG, 0);
+            f->children = astChildren(f->node);
+            match(K_HABANG);
+            match(D_LPAREN);
+            CALL(1, pushExpression(0));
+        case 1:
+            addChild(&f->children, result);
+            match(D_RPAREN);
+            CALL(2, pushFlagged(RULE_BLOCK, 1));
+        }
+        addChild(&f->children, result);
+        RETURN(f->node);
+
+    case RULE_GAWIN:
+        switch (f->step) {
+        case 0:
+            f->node = newNode(AST_GAWIN, 0);
+            f->children = astChildren(f->node);
+            match(K_GAWIN);
+            CALL(1, pushFlagged(RULE_BLOCK, 1));
+        case 1:
+            addChild(&f->children, result);
+            match(K_HABANG);
+            match(D_LPAREN);
+            CALL(2, pushExpression(0));
+        }
+        addChild(&f->children, result);
+        match(D_RPAREN);
+        match(D_SEMICOLON);
+        RETURN(f->node);
+
+    case RULE_EXPRESSION:
+        switch (f->step) {
+        case 0:  // operand: prefix operators, then a factor
+            if (check(O_NOT)) {
+                f->op = O_NOT;
+                f->line = currentLine();
+                advance();
+                CALL(1, pushExpression(PREFIX_POWER));
+            }
+            if (inSet(SET_OPERAND)) {
+                f->node = newLeaf(check(L_IDENTIFIER) ? AST_IDENTIFIER : AST_LITERAL);
+                advance();
+            } else if (check(D_LPAREN)) {
+                if (!openBracket())
+                    return AST_NONE;
+                match(D_LPAREN);
+                CALL(2, pushExpression(0));
+            } else {
+                f->node = newNode(AST_ERROR, 0);
+                syntaxErrorHere("Unexpected factor");
+            }
+            break;
+        case 1:
+            f->node = newParent(AST_UNARY, f->op, f->line, result, AST_NONE);
+            break;
+        case 2:
+            match(D_RPAREN);
+            nesting--;
+            f->node = result;
+            break;
+        case 3:
+            f->node = newParent(AST_BINARY, f->op, f->line, f->node, result);
+            break;
+        }
+        if (infixPowers[current.tokenValue].left > f->power) {
+            op = current.tokenValue;
+            f->op = op;
+            f->line = currentLine();
+            advance();
+            CALL(3, pushExpression(infixPowers[op].right));
+        }
+        RETURN(f->node);
+    }
+
+#undef CALL
+#undef RETURN
+    *done = 1;
+    return AST_NONE;
+}
+
+//parseFunctionList() run from the explicit stack
+static AstIndex parseFunctionsWithStack(void) {
+    AstIndex result = AST_NONE;
+    frameCount = 0;
+    nesting = 0;
+    stackOverflowed = 0;
+    pushRule(RULE_FUNCTIONS);
+    while (frameCount > 0 && !stackOverflowed) {
+        int done = 0;
+        AstIndex node = stepRule(result, &done);
+        if (done)
+            result = node;
+    }
+    if (stackOverflowed) {
+        //give up on the rest: keep the functions finished so far
+        result = frames[0].node;
+        frameCount = 0;
+    }
+    return result;
 }
 
 void parseProgram() {
-    printf("Parsing Program...\n");
-    parseFunctionList();
+    syntaxErrors = 0;
+    diagnosticCount = 0;
+    panicking = 0;
+    fprintf(out(), "Parsing Program...\n");
+    AstIndex program = newNode(AST_PROGRAM, 0);
+    AstIndex functions = stackLimit ? parseFunctionsWithStack() : parseFunctionList();
+    if (parserAst) {
+        parserAst->nodes[program].firstChild = functions;
+        parserAst->root = program;
+    }
 
-    if (currentToken < tokenCount)
-        printf("Warning: Extra tokens after program end\n");
+    printDiagnostics();
+    if (current.tokenValue != U_END_OF_INPUT)
+        fprintf(out(), "Warning: Extra tokens after program end\n");
     else
-        printf("Syntax Analysis Complete.\n");
-}
\ No newline at end of file
+        fprintf(out(), "Syntax Analysis Complete.\n");
+}
@@ -5,16 +5,75 @@
 #include <stdlib.h>
 #include <string.h>
 #include "../Lexer/tokens.h"  // token and enum definitions
+#include "../Lexer/lexer.h"   // LexerCtx for live lexing
+#include "../Lexer/tokring.h" // TokenRing for pipelined lexing
+#include "ast.h"              // tree the grammar rules build
 
-extern Token tokens[1000];
-extern int tokenCount;
-extern int currentToken;
+// tokens loaded from a symbol table or .tok file, one array per field so
+// check()/match() only walk the dense kinds; grows as needed
+typedef struct {
+    uint8_t *kinds;          // token kind (the category is packed in it)
+    int *lines;
+    const char **lexemes;    // into the lexeme arena or the .tok pool
+    uint32_t *lengths;       // of the lexemes, so tree leaves need no strlen
+    size_t count, capacity;
+} TokenStore;
+
+extern _Thread_local TokenStore tokenStore;
+extern _Thread_local size_t currentToken;
 
 // ---- Token Loading ----
 void loadTokensFromFile(const char *filename);
+void loadTokensFromBinary(const char *filename);  // Symbol Table.tok from Lexer --binary
+void freeTokens(void);
+
+// ---- Live Lexing ----
+// parse straight from a lexer: tokens are pulled one at a time as the
+// grammar needs them, nothing goes through the symbol table file
+void attachLexer(LexerCtx *lexer);
+// same, but the tokens come from a lexer running on another thread
+// (source is the buffer their offsets point into)
+void attachRing(TokenRing *ring, const char *source);
+// same, over a token list kept by the caller (comments are skipped);
+// the parser can be moved to any list index, which incremental
+// reparsing uses to start at a statement
+void attachTokenList(const TokenList *list, const char *source);
+void seekToken(size_t index);
+// list index of the current token (list count past the end)
+size_t currentTokenIndex(void);
+
+// ---- Diagnostics ----
+// messages of the calling thread's parser go to file (NULL = stdout)
+void setParserOutput(FILE *file);
+// syntax errors reported since the last parseProgram() started
+int syntaxErrorCount(void);
+// grammar errors go to sink (with the list index of the token) instead of
+// being printed, NULL to print again
+typedef void (*SyntaxErrorSink)(void *context, size_t tokenIndex, const char *message);
+void setSyntaxErrorSink(SyntaxErrorSink sink, void *context);
+// one error line as syntaxError() prints it
+void printSyntaxError(FILE *file, const char *message, int lineNumber, const char *lexeme);
+// a parse prints at most PARSER_MAX_DIAGNOSTICS errors, then this line
+#define PARSER_MAX_DIAGNOSTICS 100
+void printHiddenErrors(FILE *file, int hidden);
+
+// ---- Syntax Tree ----
+// the calling thread's parses build their tree into ast (reset first, root
+// set by parseProgram), NULL to only validate. Node text points into the
+// parser's tokens or source, valid until freeTokens()
+void setParserAst(Ast *ast);
+
+// ---- Explicit-Stack Mode ----
+#define PARSER_NESTING_LIMIT 100000  // nested braces and parentheses allowed by default
+// the calling thread's parses keep open rules on a heap stack instead of
+// recursing on the C stack; more than nestingLimit braces and parentheses
+// open inside each other is a syntax error. 0 = recursive rules (the
+// default for a new thread)
+void setParserStackLimit(size_t nestingLimit);
 
 // ---- Utility ----
 void match(int expected);
+void advance(void);
 Token getCurrentToken();
 int check(int expected);
 
@@ -22,20 +81,24 @@ int check(int expected);
 void parseProgram();
 
 // ---- Grammar Rules ----
-void parseFunctionList();
-void parseFunction();
-void parseStatementList();
-void parseStatement();
-void parseDeclarationStatement();
-void parseAssignmentStatement();
-void parseConditionalStatement();
-void parseLoopStatement();
-void parseExpression();
-void parseExpressionTail();
-void parseTerm();
-void parseTermTail();
-void parseFactor();
-void parseBooleanExpression();
-void parseRelOp();
+// every rule returns its node, AST_NONE when no tree is being built
+AstIndex parseFunctionList();
+AstIndex parseFunction();
+AstIndex parseFunctionHead();
+void parseFunctionTail();
+int atStatementStart();
+// }, wala or the end of input: where a statement list stops
+int atBlockEnd();
+AstIndex parseStatementList();
+AstIndex parseStatement();
+AstIndex parseDeclarationStatement();
+AstIndex parseAssignmentStatement();
+AstIndex parseConditionalStatement();
+AstIndex parseLoopStatement();
+AstIndex parseExpression();
+// operators that bind tighter than minPower and their operands
+AstIndex parseExpressionAbove(int minPower);
+AstIndex parseFactor();
+AstIndex parseBooleanExpression();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,421 @@
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "semantic.h"
+#include "../Lexer/tokens.h"
+
+#define NO_TYPE 0  // not a value, or one whose type an error already hid
+
+//declaration an undo entry puts back when its block ends
+struct SemanticUndo {
+    uint32_t id;
+    uint8_t type, array;
+    uint32_t block, line;
+};
+
+//a node being walked: children are entered one at a time and hand their
+//type back through resume()
+struct SemanticFrame {
+    AstIndex node;
+    AstIndex child;       // next child to enter
+    uint32_t id;          // ASSIGNMENT, DECLARATOR: the target's symbol
+    uint32_t mark;        // BLOCK: undo entries before it
+    uint32_t outer;       // BLOCK: the block around it
+    uint8_t type;         // DECLARATION: declared type; BINARY, UNARY: result
+    uint8_t left;         // BINARY: type of the left operand
+    uint8_t operands;     // BINARY: operands seen so far
+};
+
+typedef struct SemanticUndo SemanticUndo;
+typedef struct SemanticFrame SemanticFrame;
+
+//type of a literal's value, the data type kind a declaration would name
+static const uint8_t literalTypes[TOKEN_KINDS] = {
+    [L_BILANG_LITERAL]  = R_BILANG,
+    [L_LUTANG_LITERAL]  = R_LUTANG,
+    [L_KWERDAS_LITERAL] = R_KWERDAS,
+    [L_BULYAN_LITERAL]  = R_BULYAN,
+};
+
+//operators by TOKEN_INDEX, for messages
+static const char *const operatorText[] = {
+    "+", "-", "*", "/", "^", "%", "=", "==", "!=", "<", ">", "<=", ">=", "&&", "||", "!"
+};
+
+static const char *typeName(int type) {
+    switch (type) {
+        case R_BILANG: return "bilang";
+        case R_LUTANG: return "lutang";
+        case R_BULYAN: return "bulyan";
+        case R_KWERDAS: return "kwerdas";
+        default: return "?";
+    }
+}
+
+static int isNumber(int type) {
+    return type == R_BILANG || type == R_LUTANG;
+}
+
+static void *growArray(void *items, size_t capacity, size_t itemSize) {
+    void *grown = realloc(items, capacity * itemSize);
+    if (!grown) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    return grown;
+}
+
+void semanticInit(SemanticCtx *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void semanticFree(SemanticCtx *ctx) {
+    free(ctx->symbols);
+    free(ctx->slots);
+    free(ctx->undo);
+    free(ctx->frames);
+    semanticInit(ctx);
+}
+
+// ---- Errors ----
+
+//one error line, the ones past SEMANTIC_MAX_DIAGNOSTICS only counted
+static void semanticError(SemanticCtx *ctx, uint32_t line, const char *format, ...) {
+    va_list args;
+    if (ctx->errors++ >= SEMANTIC_MAX_DIAGNOSTICS)
+        return;
+    fprintf(ctx->output, "Semantic Error at line %u: ", line);
+    va_start(args, format);
+    vfprintf(ctx->output, format, args);
+    va_end(args);
+    fputc('\n', ctx->output);
+}
+
+// ---- Interning ----
+
+//FNV-1a
+static uint32_t hashText(const char *text, uint32_t length) {
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < length; i++)
+        hash = (hash ^ (uint8_t)text[i]) * 16777619u;
+    return hash;
+}
+
+//double the slots and put every id back
+static void growSlots(SemanticCtx *ctx) {
+    uint32_t slotCount = ctx->slotCount ? ctx->slotCount * 2 : 1024;
+    uint32_t mask = slotCount - 1;
+    free(ctx->slots);
+    ctx->slots = calloc(slotCount, sizeof(uint32_t));
+    if (!ctx->slots) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    ctx->slotCount = slotCount;
+    for (uint32_t id = 0; id < ctx->symbolCount; id++) {
+        uint32_t slot = ctx->symbols[id].hash & mask;
+        while (ctx->slots[slot])
+            slot = (slot + 1) & mask;
+        ctx->slots[slot] = id + 1;
+    }
+}
+
+//dense id of an identifier's text, a new one (nothing declared) the first
+//time it is seen. The only place text is compared
+static uint32_t intern(SemanticCtx *ctx, const AstNode *leaf) {
+    uint32_t hash = hashText(leaf->text, leaf->length);
+    uint32_t mask = ctx->slotCount - 1;
+    uint32_t slot = hash & mask;
+    for (; ctx->slots[slot]; slot = (slot + 1) & mask) {
+        Symbol *symbol = &ctx->symbols[ctx->slots[slot] - 1];
+        if (symbol->hash == hash && symbol->length == leaf->length
+            && memcmp(symbol->text, leaf->text, leaf->length) == 0)
+            return ctx->slots[slot] - 1;
+    }
+
+    if (ctx->symbolCount == ctx->symbolCapacity) {
+        ctx->symbolCapacity = ctx->symbolCapacity ? ctx->symbolCapacity * 2 : 256;
+        ctx->symbols = growArray(ctx->symbols, ctx->symbolCapacity, sizeof(Symbol));
+    }
+    uint32_t id = ctx->symbolCount++;
+    Symbol *symbol = &ctx->symbols[id];
+    memset(symbol, 0, sizeof(*symbol));
+    symbol->text = leaf->text;
+    symbol->length = leaf->length;
+    symbol->hash = hash;
+    ctx->slots[slot] = id + 1;
+    if (ctx->symbolCount * 2 > ctx->slotCount)
+        growSlots(ctx);
+    return id;
+}
+
+// ---- Scopes ----
+
+//declare the identifier leaf in the innermost block, shadowing outer ones
+static uint32_t declare(SemanticCtx *ctx, const AstNode *leaf, int type, int array, uint32_t block) {
+    uint32_t id = intern(ctx, leaf);
+    Symbol *symbol = &ctx->symbols[id];
+    if (symbol->type != NO_TYPE && symbol->block == block) {
+        semanticError(ctx, leaf->line, "'%.*s' is already declared in this block (line %u)",
+                      (int)leaf->length, leaf->text, symbol->line);
+        return id;
+    }
+    if (ctx->undoCount == ctx->undoCapacity) {
+        ctx->undoCapacity = ctx->undoCapacity ? ctx->undoCapacity * 2 : 256;
+        ctx->undo = growArray(ctx->undo, ctx->undoCapacity, sizeof(SemanticUndo));
+    }
+    SemanticUndo *undo = &ctx->undo[ctx->undoCount++];
+    undo->id = id;
+    undo->type = symbol->type;
+    undo->array = symbol->array;
+    undo->block = symbol->block;
+    undo->line = symbol->line;
+    symbol->type = (uint8_t)type;
+    symbol->array = (uint8_t)array;
+    symbol->block = block;
+    symbol->line = leaf->line;
+    return id;
+}
+
+//type of the declaration an identifier leaf refers to, NO_TYPE (and an
+//error) when there is none
+static int resolve(SemanticCtx *ctx, const AstNode *leaf, uint32_t *id) {
+    *id = intern(ctx, leaf);
+    int type = ctx->symbols[*id].type;
+    if (type == NO_TYPE)
+        semanticError(ctx, leaf->line, "'%.*s' is not declared", (int)leaf->length, leaf->text);
+    return type;
+}
+
+//put back what the declarations of a block shadowed
+static void closeBlock(SemanticCtx *ctx, uint32_t mark) {
+    while (ctx->undoCount > mark) {
+        SemanticUndo *undo = &ctx->undo[--ctx->undoCount];
+        Symbol *symbol = &ctx->symbols[undo->id];
+        symbol->type = undo->type;
+        symbol->array = undo->array;
+        symbol->block = undo->block;
+        symbol->line = undo->line;
+    }
+}
+
+// ---- Types ----
+
+static int isExpression(int kind) {
+    return kind == AST_BINARY || kind == AST_UNARY || kind == AST_IDENTIFIER
+        || kind == AST_LITERAL || kind == AST_ERROR;
+}
+
+//a value of type value stored where target goes: the same type, or a
+//bilang widened to lutang
+static void checkAssignable(SemanticCtx *ctx, const Symbol *target, int value, uint32_t line) {
+    int type = target->type;
+    if (type == NO_TYPE || value == NO_TYPE || value == type)
+        return;
+    if (type == R_LUTANG && value == R_BILANG)
+        return;
+    semanticError(ctx, line, "Cannot assign %s to %s%s '%.*s'", typeName(value), typeName(type),
+                  target->array ? " array" : "", (int)target->length, target->text);
+}
+
+static void checkCondition(SemanticCtx *ctx, int type, uint32_t line) {
+    if (type != NO_TYPE && type != R_BULYAN)
+        semanticError(ctx, line, "Condition is %s, not bulyan", typeName(type));
+}
+
+//result of an infix operator; operands of the wrong type are reported and
+//give NO_TYPE for arithmetic, so one mistake is not reported all the way up
+static int binaryType(SemanticCtx *ctx, int op, int left, int right, uint32_t line) {
+    const char *text = operatorText[TOKEN_INDEX(op)];
+    switch (op) {
+    case O_AND:
+    case O_OR:
+        if ((left != NO_TYPE && left != R_BULYAN) || (right != NO_TYPE && right != R_BULYAN))
+            semanticError(ctx, line, "Operands of '%s' must be bulyan", text);
+        return R_BULYAN;
+    case O_EQUAL:
+    case O_NOT_EQUAL:
+        if (left != NO_TYPE && right != NO_TYPE && left != right && !(isNumber(left) && isNumber(right)))
+            semanticError(ctx, line, "Cannot compare %s with %s", typeName(left), typeName(right));
+        return R_BULYAN;
+    case O_LESS:
+    case O_GREATER:
+    case O_LESS_EQ:
+    case O_GREATER_EQ:
+        if ((left != NO_TYPE && !isNumber(left)) || (right != NO_TYPE && !isNumber(right)))
+            semanticError(ctx, line, "Operands of '%s' must be numbers", text);
+        return R_BULYAN;
+    default:
+        if (left == NO_TYPE || right == NO_TYPE)
+            return NO_TYPE;
+        if (!isNumber(left) || !isNumber(right)) {
+            semanticError(ctx, line, "Operands of '%s' must be numbers", text);
+            return NO_TYPE;
+        }
+        return left == R_LUTANG || right == R_LUTANG ? R_LUTANG : R_BILANG;
+    }
+}
+
+// ---- Walk ----
+
+//a child of f's node is done, type = its value
+static void resume(SemanticCtx *ctx, SemanticFrame *f, const AstNode *nodes, AstIndex child, int type) {
+    const AstNode *node = &nodes[f->node];
+    if (!isExpression(nodes[child].kind))
+        return;
+    switch (node->kind) {
+    case AST_ASSIGNMENT:
+    case AST_DECLARATOR:
+        if (f->id != UINT32_MAX)
+            checkAssignable(ctx, &ctx->symbols[f->id], type, nodes[child].line);
+        break;
+    case AST_KUNG:
+    case AST_KUNDIMAN:
+    case AST_PARA:
+    case AST_HABANG:
+    case AST_GAWIN:
+        checkCondition(ctx, type, nodes[child].line);
+        break;
+    case AST_UNARY:
+        if (type != NO_TYPE && type != R_BULYAN)
+            semanticError(ctx, node->line, "Operand of '!' must be bulyan");
+        f->type = R_BULYAN;
+        break;
+    case AST_BINARY:
+        if (f->operands++ == 0)
+            f->left = (uint8_t)type;
+        else
+            f->type = (uint8_t)binaryType(ctx, node->token, f->left, type, node->line);
+        break;
+    }
+}
+
+static SemanticFrame *push(SemanticCtx *ctx, AstIndex node, AstIndex child) {
+    if (ctx->frameCount == ctx->frameCapacity) {
+        ctx->frameCapacity = ctx->frameCapacity ? ctx->frameCapacity * 2 : 64;
+        ctx->frames = growArray(ctx->frames, ctx->frameCapacity, sizeof(SemanticFrame));
+    }
+    SemanticFrame *f = &ctx->frames[ctx->frameCount++];
+    memset(f, 0, sizeof(*f));
+    f->node = node;
+    f->child = child;
+    f->id = UINT32_MAX;
+    return f;
+}
+
+//start on a node: leaves are done at once and handed to the frame on top,
+//inner nodes get a frame of their own. Frame pointers are stale after this
+static void enter(SemanticCtx *ctx, const AstNode *nodes, AstIndex index, uint32_t *block) {
+    const AstNode *node = &nodes[index];
+    SemanticFrame *f;
+    AstIndex child;
+    uint32_t id;
+
+    switch (node->kind) {
+    case AST_IDENTIFIER:
+        resume(ctx, &ctx->frames[ctx->frameCount - 1], nodes, index, resolve(ctx, node, &id));
+        return;
+    case AST_LITERAL:
+        resume(ctx, &ctx->frames[ctx->frameCount - 1], nodes, index, literalTypes[node->token]);
+        return;
+    }
+
+    child = node->firstChild;
+    switch (node->kind) {
+    case AST_BLOCK:
+        f = push(ctx, index, child);
+        f->mark = (uint32_t)ctx->undoCount;
+        f->outer = *block;
+        *block = ++ctx->blocks;
+        break;
+    case AST_DECLARATION:
+        f = push(ctx, index, child);
+        f->type = node->token;
+        break;
+    case AST_DECLARATOR: {
+        int type = ctx->frames[ctx->frameCount - 1].type;
+        id = UINT32_MAX;
+        if (child != AST_NONE && nodes[child].kind == AST_IDENTIFIER) {
+            id = declare(ctx, &nodes[child], type, node->flags & AST_ARRAY, *block);
+            child = nodes[child].nextSibling;
+        }
+        //[size]: a bilang literal, counted in the digits so leading zeros do not matter.
+        //`d[] = 0` has no size, so with an initializer the size is only there
+        //if another child follows it
+        if ((node->flags & AST_ARRAY) && child != AST_NONE && nodes[child].kind == AST_LITERAL
+            && (!(node->flags & AST_INITIALIZED) || nodes[child].nextSibling != AST_NONE)) {
+            const AstNode *size = &nodes[child];
+            uint32_t i = 0;
+            while (i < size->length && size->text[i] == '0')
+                i++;
+            if (i == size->length)
+                semanticError(ctx, size->line, "Array size must be greater than 0");
+            child = size->nextSibling;
+        }
+        f = push(ctx, index, child);
+        f->id = id;
+        break;
+    }
+    case AST_ASSIGNMENT:
+        id = UINT32_MAX;
+        if (child != AST_NONE && nodes[child].kind == AST_IDENTIFIER) {
+            if (resolve(ctx, &nodes[child], &id) == NO_TYPE)
+                id = UINT32_MAX;
+            child = nodes[child].nextSibling;
+        }
+        f = push(ctx, index, child);
+        f->id = id;
+        break;
+    default:
+        push(ctx, index, child);
+        break;
+    }
+}
+
+int semanticCheck(SemanticCtx *ctx, const Ast *ast, FILE *file) {
+    const AstNode *nodes = ast->nodes;
+    uint32_t block = 0;
+
+    //ids and their text belong to the tree of the last check
+    ctx->symbolCount = 0;
+    if (ctx->slots)
+        memset(ctx->slots, 0, ctx->slotCount * sizeof(uint32_t));
+    else
+        growSlots(ctx);
+    ctx->undoCount = 0;
+    ctx->frameCount = 0;
+    ctx->blocks = 0;
+    ctx->errors = 0;
+    ctx->output = file ? file : stdout;
+
+    if (ast->root != AST_NONE)
+        push(ctx, ast->root, nodes[ast->root].firstChild);
+    while (ctx->frameCount > 0) {
+        SemanticFrame *f = &ctx->frames[ctx->frameCount - 1];
+        if (f->child != AST_NONE) {
+            AstIndex child = f->child;
+            f->child = nodes[child].nextSibling;
+            enter(ctx, nodes, child, &block);
+            continue;
+        }
+
+        //all children done: close the node and hand its type up
+        AstIndex done = f->node;
+        int type = NO_TYPE;
+        if (nodes[done].kind == AST_BLOCK) {
+            closeBlock(ctx, f->mark);
+            block = f->outer;
+        } else if (nodes[done].kind == AST_BINARY || nodes[done].kind == AST_UNARY) {
+            type = f->type;
+        }
+        ctx->frameCount--;
+        if (ctx->frameCount > 0)
+            resume(ctx, &ctx->frames[ctx->frameCount - 1], nodes, done, type);
+    }
+
+    if (ctx->errors > SEMANTIC_MAX_DIAGNOSTICS)
+        fprintf(ctx->output, "Too many semantic errors, %d more not shown\n",
+                ctx->errors - SEMANTIC_MAX_DIAGNOSTICS);
+    fprintf(ctx->output, "Semantic Analysis Complete.\n");
+    return ctx->errors;
+}
@@ -0,0 +1,53 @@
+#ifndef SEMANTIC_H
+#define SEMANTIC_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "ast.h"
+
+//Checks a parsed tree: every identifier used must be declared in an
+//enclosing block (and only once per block), and every value must fit
+//where it goes: initializers and assignments the declared type (a bilang
+//value also fits a lutang), conditions bulyan, operands their operator.
+//
+//Identifiers are interned to dense ids as they are met, and each id
+//indexes a flat array holding its innermost declaration, so resolving a
+//use is one load. A declaration saves the entry it shadows on an undo
+//log that the end of its block unwinds. The tree is walked once on a heap
+//stack, so the pass is linear in the nodes and nesting costs no C stack.
+
+#define SEMANTIC_MAX_DIAGNOSTICS 100  // errors printed, the rest counted
+
+//an interned identifier: where its text is and the declaration in scope
+typedef struct {
+    const char *text;      // not NUL terminated, see AstNode
+    uint32_t length, hash;
+    uint8_t type;          // data type kind of the innermost declaration, 0 = none
+    uint8_t array;         // that declaration has a [size]
+    uint32_t block;        // serial number of the block it was declared in
+    uint32_t line;
+} Symbol;
+
+//everything a check needs, kept between checks so the arrays are reused
+typedef struct {
+    Symbol *symbols;           // by id
+    uint32_t symbolCount, symbolCapacity;
+    uint32_t *slots;           // hash table: id + 1, 0 = empty
+    uint32_t slotCount;        // power of two
+    struct SemanticUndo *undo; // declarations shadowed by open blocks
+    size_t undoCount, undoCapacity;
+    struct SemanticFrame *frames;
+    size_t frameCount, frameCapacity;
+    uint32_t blocks;           // blocks opened so far
+    int errors;
+    FILE *output;
+} SemanticCtx;
+
+void semanticInit(SemanticCtx *ctx);
+void semanticFree(SemanticCtx *ctx);
+
+//check ast, printing errors to file (NULL = stdout); returns how many
+//there were. Symbols stay valid until the next check or semanticFree()
+int semanticCheck(SemanticCtx *ctx, const Ast *ast, FILE *file);
+
+#endif
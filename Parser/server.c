@@ -0,0 +1,451 @@
+//open_memstream(), realpath() and lstat() are not C11, ask the C library for them
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "server.h"
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "parser.h"
+#include "../Lexer/source.h"
+#include "../Lexer/symwriter.h"
+
+#define LINE_MAX_BYTES (PATH_MAX + 64)  // longest request line
+
+//buffered reads from a socket
+typedef struct {
+    int fd;
+    char *data;
+    size_t start, end, capacity;
+} Reader;
+
+//one client: its buffers and token list live as long as the connection
+typedef struct {
+    Reader in;
+    char *body;
+    size_t bodyCapacity;
+    TokenList tokens;
+} Connection;
+
+static void *allocate(size_t size) {
+    void *memory = malloc(size);
+    if (!memory) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    return memory;
+}
+
+static void readerInit(Reader *reader, int fd) {
+    reader->fd = fd;
+    reader->capacity = 64 * 1024;
+    reader->data = allocate(reader->capacity);
+    reader->start = reader->end = 0;
+}
+
+//more bytes into the buffer, 0 at end of stream or on error
+static int fill(Reader *reader) {
+    if (reader->start > 0) {
+        memmove(reader->data, reader->data + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->end == reader->capacity)
+        return 0;
+    for (;;) {
+        ssize_t got = read(reader->fd, reader->data + reader->end, reader->capacity - reader->end);
+        if (got > 0) {
+            reader->end += (size_t)got;
+            return 1;
+        }
+        if (got < 0 && errno == EINTR)
+            continue;
+        return 0;
+    }
+}
+
+//next line without its '\n', valid until the next read; NULL at end of
+//stream or when the line is too long
+static char *readLine(Reader *reader) {
+    size_t scanned = 0;
+    for (;;) {
+        char *line = reader->data + reader->start;
+        char *newline = memchr(line + scanned, '\n', reader->end - reader->start - scanned);
+        if (newline) {
+            *newline = '\0';
+            reader->start = (size_t)(newline + 1 - reader->data);
+            return line;
+        }
+        scanned = reader->end - reader->start;
+        if (scanned >= LINE_MAX_BYTES || !fill(reader))
+            return NULL;
+    }
+}
+
+//exactly length bytes into out, 0 if the stream ends first
+static int readExactly(Reader *reader, char *out, size_t length) {
+    size_t buffered = reader->end - reader->start;
+    size_t take = buffered < length ? buffered : length;
+    memcpy(out, reader->data + reader->start, take);
+    reader->start += take;
+    while (take < length) {
+        ssize_t got = read(reader->fd, out + take, length - take);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            return 0;
+        take += (size_t)got;
+    }
+    return 1;
+}
+
+static int sendAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return 0;
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return 1;
+}
+
+static int sendError(int fd, const char *reason) {
+    char line[256];
+    int length = snprintf(line, sizeof line, "ERROR %s\n", reason);
+    return sendAll(fd, line, (size_t)length);
+}
+
+//answer a request the connection cannot go on after, 0 to close it
+static int reject(Connection *conn, const char *reason) {
+    sendError(conn->in.fd, reason);
+    return 0;
+}
+
+//lex source once into the connection's token list, then write the symbol
+//table from it and parse it, as asked
+static int answer(Connection *conn, const char *source, size_t length, int wantSymbols, int wantParse) {
+    LexerCtx lexer;
+    TokenSpan tok;
+    char *symbols = NULL, *messages = NULL;
+    size_t symbolBytes = 0, messageBytes = 0;
+    int errors = 0, ok;
+
+    conn->tokens.count = 0;
+    lexer_init(&lexer, source, length);
+    while (lexer_next(&lexer, &tok))
+        tokenListPush(&conn->tokens, &tok);
+
+    if (wantSymbols) {
+        FILE *out = open_memstream(&symbols, &symbolBytes);
+        SymWriter writer;
+        if (!out) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        symWriterOpen(&writer, out, SYM_TEXT);
+        symWriterHeader(&writer);
+        for (size_t i = 0; i < conn->tokens.count; i++)
+            symWriterToken(&writer, &conn->tokens.tokens[i], source);
+        symWriterClose(&writer);
+        fclose(out);
+    }
+
+    if (wantParse) {
+        FILE *out = open_memstream(&messages, &messageBytes);
+        if (!out) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        setParserOutput(out);
+        attachTokenList(&conn->tokens, source); //keeps this thread's lexeme arena
+        parseProgram();
+        errors = syntaxErrorCount();
+        setParserOutput(NULL);
+        fclose(out);
+    }
+
+    char header[96];
+    int headerBytes = snprintf(header, sizeof header, "OK %d %zu %zu\n", errors, symbolBytes, messageBytes);
+    ok = sendAll(conn->in.fd, header, (size_t)headerBytes)
+         && sendAll(conn->in.fd, symbols ? symbols : "", symbolBytes)
+         && sendAll(conn->in.fd, messages ? messages : "", messageBytes);
+    free(symbols);
+    free(messages);
+    return ok;
+}
+
+//"s", "p", "sp"... into the two flags, 0 if anything else is in there
+static int parseParts(const char *parts, int *wantSymbols, int *wantParse) {
+    *wantSymbols = *wantParse = 0;
+    for (; *parts; parts++) {
+        if (*parts == 's')
+            *wantSymbols = 1;
+        else if (*parts == 'p')
+            *wantParse = 1;
+        else
+            return 0;
+    }
+    return 1;
+}
+
+//one request, 0 when the connection should be closed
+static int serveRequest(Connection *conn) {
+    char *line = readLine(&conn->in);
+    int wantSymbols, wantParse;
+    if (!line)
+        return 0;
+
+    char *verb = line;
+    char *parts = strchr(verb, ' ');
+    char *argument = parts ? strchr(parts + 1, ' ') : NULL;
+    if (!argument)
+        return reject(conn, "malformed request");
+    *parts++ = '\0';
+    *argument++ = '\0';
+    if (strcmp(verb, "SOURCE") != 0 && strcmp(verb, "PATH") != 0)
+        return reject(conn, "unknown request");
+    if (!parseParts(parts, &wantSymbols, &wantParse))
+        return reject(conn, "unknown parts");
+
+    if (strcmp(verb, "SOURCE") == 0) {
+        char *end;
+        unsigned long long length = strtoull(argument, &end, 10);
+        if (*argument == '\0' || *end != '\0' || length > SERVER_MAX_SOURCE)
+            return reject(conn, "bad length");
+        if (length + 1 > conn->bodyCapacity) {
+            free(conn->body);
+            conn->bodyCapacity = (size_t)length + 1;
+            conn->body = allocate(conn->bodyCapacity);
+        }
+        if (!readExactly(&conn->in, conn->body, (size_t)length))
+            return 0;
+        conn->body[length] = '\0';
+        return answer(conn, conn->body, (size_t)length, wantSymbols, wantParse);
+    }
+
+    //PATH
+    FILE *file = fopen(argument, "r");
+    SourceBuffer src;
+    int ok;
+    if (!file)
+        return sendError(conn->in.fd, "cannot open file");
+    if (sourceLoad(&src, file) != 0) {
+        fclose(file);
+        return sendError(conn->in.fd, "cannot read file");
+    }
+    fclose(file);
+    ok = answer(conn, src.data, src.length, wantSymbols, wantParse);
+    sourceRelease(&src);
+    return ok;
+}
+
+static void *connectionMain(void *arg) {
+    Connection *conn = arg;
+    setParserStackLimit(PARSER_NESTING_LIMIT); //no input may crash the server by nesting deep
+    while (serveRequest(conn))
+        ;
+    close(conn->in.fd);
+    free(conn->in.data);
+    free(conn->body);
+    tokenListFree(&conn->tokens);
+    freeTokens();
+    free(conn);
+    return NULL;
+}
+
+//address for socketPath, 0 if the path does not fit
+static int socketAddress(struct sockaddr_un *address, const char *socketPath) {
+    memset(address, 0, sizeof *address);
+    address->sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof address->sun_path)
+        return 0;
+    strcpy(address->sun_path, socketPath);
+    return 1;
+}
+
+int runServer(const char *socketPath) {
+    struct sockaddr_un address;
+    int listener;
+
+    if (!socketAddress(&address, socketPath)) {
+        printf("Socket path too long: %s\n", socketPath);
+        return 2;
+    }
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        printf("Cannot create a socket\n");
+        return 2;
+    }
+    //a socket left over from a server that was killed; anything else stays
+    struct stat info;
+    if (lstat(socketPath, &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            printf("Cannot listen on %s: path exists and is not a socket\n", socketPath);
+            close(listener);
+            return 2;
+        }
+        unlink(socketPath);
+    }
+    if (bind(listener, (struct sockaddr *)&address, sizeof address) != 0
+        || listen(listener, SOMAXCONN) != 0) {
+        printf("Cannot listen on %s\n", socketPath);
+        close(listener);
+        return 2;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    initialize_lexer(); //shared tables, set up before any connection thread
+    printf("Listening on %s\n", socketPath);
+    fflush(stdout);
+
+    for (;;) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            printf("Cannot accept connections on %s\n", socketPath);
+            close(listener);
+            return 2;
+        }
+
+        Connection *conn = calloc(1, sizeof(Connection));
+        pthread_t thread;
+        if (!conn) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        readerInit(&conn->in, fd);
+        if (pthread_create(&thread, NULL, connectionMain, conn) != 0) {
+            close(fd);
+            free(conn->in.data);
+            free(conn);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+}
+
+//copy length bytes of the answer to stdout, 0 if the stream ends first
+static int relay(Reader *reader, size_t length) {
+    while (length > 0) {
+        if (reader->start == reader->end && !fill(reader))
+            return 0;
+        size_t take = reader->end - reader->start;
+        if (take > length)
+            take = length;
+        fwrite(reader->data + reader->start, 1, take, stdout);
+        reader->start += take;
+        length -= take;
+    }
+    return 1;
+}
+
+//send one file, print the answer; 0 clean, 1 syntax errors, 2 failed
+static int request(Reader *reader, const char *path, const char *parts) {
+    char line[LINE_MAX_BYTES];
+    int length;
+
+    if (strcmp(path, "-") == 0) {
+        SourceBuffer src;
+        int ok;
+        if (sourceLoad(&src, stdin) != 0) {
+            printf("Cannot read standard input\n");
+            return 2;
+        }
+        length = snprintf(line, sizeof line, "SOURCE %s %zu\n", parts, src.length);
+        ok = sendAll(reader->fd, line, (size_t)length) && sendAll(reader->fd, src.data, src.length);
+        sourceRelease(&src);
+        if (!ok)
+            return -1;
+    } else {
+        char full[PATH_MAX];
+        if (!realpath(path, full)) {
+            printf("Cannot open %s\n", path);
+            return 2;
+        }
+        length = snprintf(line, sizeof line, "PATH %s %s\n", parts, full);
+        if (!sendAll(reader->fd, line, (size_t)length))
+            return -1;
+    }
+
+    char *answerLine = readLine(reader);
+    int errors;
+    size_t symbolBytes, messageBytes;
+    if (!answerLine)
+        return -1;
+    if (strncmp(answerLine, "ERROR ", 6) == 0) {
+        printf("%s: %s\n", path, answerLine + 6);
+        return 2;
+    }
+    if (sscanf(answerLine, "OK %d %zu %zu", &errors, &symbolBytes, &messageBytes) != 3
+        || !relay(reader, symbolBytes) || !relay(reader, messageBytes))
+        return -1;
+    return errors ? 1 : 0;
+}
+
+int runClient(const char *socketPath, char **paths, int pathCount, int symbols) {
+    struct sockaddr_un address;
+    Reader reader;
+    int status = 0;
+
+    if (!socketAddress(&address, socketPath)) {
+        printf("Socket path too long: %s\n", socketPath);
+        return 2;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof address) != 0) {
+        printf("Cannot connect to %s\n", socketPath);
+        if (fd >= 0)
+            close(fd);
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    readerInit(&reader, fd);
+
+    for (int i = 0; i < pathCount; i++) {
+        int result = request(&reader, paths[i], symbols ? "sp" : "p");
+        if (result < 0) {
+            printf("Lost the connection to %s\n", socketPath);
+            status = 2;
+            break;
+        }
+        if (result > status)
+            status = result;
+    }
+    fflush(stdout);
+    close(fd);
+    free(reader.data);
+    return status;
+}
+
+#else
+
+int runServer(const char *socketPath) {
+    (void)socketPath;
+    printf("Server mode needs UNIX domain sockets\n");
+    return 2;
+}
+
+int runClient(const char *socketPath, char **paths, int pathCount, int symbols) {
+    (void)socketPath;
+    (void)paths;
+    (void)pathCount;
+    (void)symbols;
+    printf("Server mode needs UNIX domain sockets\n");
+    return 2;
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+//Server mode: one long-running process keeps the lexer tables warm and
+//answers lex/parse requests on a UNIX domain socket, so a build that checks
+//thousands of files pays for process startup once instead of per file.
+//Every connection gets its own thread and keeps its buffers and token list
+//from one request to the next.
+//
+//Requests on a connection, one after another:
+//  PATH <parts> <path>\n              lex/parse the file at path (as the
+//                                     server sees it, so better absolute)
+//  SOURCE <parts> <length>\n<bytes>   lex/parse the bytes sent
+//parts is any of s (symbol table, as in Symbol Table.txt) and p (parser
+//messages, as parser prints them). Answer:
+//  OK <syntax errors> <symbol bytes> <message bytes>\n<symbols><messages>
+//  ERROR <reason>\n
+//A malformed request closes the connection.
+
+#define SERVER_MAX_SOURCE (1u << 30)  // biggest SOURCE body accepted
+
+//listen on socketPath until killed, returns the exit status on failure
+int runServer(const char *socketPath);
+
+//send each file (- = stdin) to the server and print what comes back,
+//symbol table first when symbols is set. Returns 0 all clean, 1 some file
+//had syntax errors, 2 some request failed
+int runClient(const char *socketPath, char **paths, int pathCount, int symbols);
+
+#endif
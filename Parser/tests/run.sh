@@ -0,0 +1,49 @@
+#!/bin/sh
+# Parser regression tests. Every tests/NAME.usb is parsed with --check
+# --ast in each parsing mode (the default explicit stack, --recursive and
+# --pipe), and all three must print exactly tests/NAME.expected: the same
+# messages and the same tree, so the two copies of the grammar cannot
+# drift apart.
+# Each input then goes through tools/editcheck.c: seeded random edits,
+# incremental re-parsing after each, compared with a full parse; its line
+# of what an edit cost (tokens parsed, entries shifted, time) is printed.
+# Run from the Parser folder:  sh tests/run.sh
+# CC picks the compiler. After a deliberate change to the messages,
+# sh tests/run.sh --update rewrites the .expected files (review the diff).
+cd "$(dirname "$0")/.." || exit 1
+CC=${CC:-cc}
+bin=$(mktemp -d) || exit 1
+trap 'rm -rf "$bin"' EXIT
+
+lexer=$(ls ../Lexer/*.c | grep -v '/main\.c$')
+$CC -O2 -pthread *.c $lexer -o "$bin/parser" -lm || exit 1
+$CC -O2 -pthread tools/editcheck.c parser.c ast.c incparse.c $lexer -o "$bin/editcheck" -lm || exit 1
+
+#a small C stack, so a rule that recurses where it should not fails here
+#and not only on inputs far bigger than these
+ulimit -s 256
+
+failed=0
+for input in tests/*.usb; do
+    expected=${input%.usb}.expected
+    if [ "$1" = "--update" ]; then
+        "$bin/parser" --check --ast "$input" > "$expected"
+    fi
+    for mode in "" --recursive --pipe; do
+        if ! "$bin/parser" --check --ast $mode "$input" | cmp -s - "$expected"; then
+            echo "FAIL $input ${mode:-(explicit stack)}"
+            "$bin/parser" --check --ast $mode "$input" | diff "$expected" - | head -20
+            failed=1
+        fi
+    done
+    if "$bin/editcheck" "$input" 500 1 > "$bin/edits.txt"; then
+        echo "$input: $(cat "$bin/edits.txt")"
+    else
+        echo "FAIL $input (incremental re-parsing)"
+        cat "$bin/edits.txt"
+        failed=1
+    fi
+done
+
+[ $failed = 0 ] && echo "parser tests passed"
+exit $failed
@@ -1,5 +1,6 @@
 #ifndef TOKENS_H
 #define TOKENS_H
+#include <stdint.h>
 //Category
 typedef enum {
     CAT_KEYWORD,
@@ -12,10 +13,18 @@ typedef enum {
     CAT_UNKNOWN
 } TokenCategory;
 
+//Every token kind below is unique across categories: the category sits in
+//the top 3 bits and the index within the category in the low 5, so one
+//byte names a token, check() is one compare and a kind can index a table
+#define TOKEN_KIND(category, index) ((category) << 5 | (index))
+#define TOKEN_CATEGORY(kind) ((kind) >> 5)
+#define TOKEN_INDEX(kind) ((kind) & 0x1f)
+#define TOKEN_KINDS 256
+
 
 //Tokens for keywords category:
 typedef enum {
-    K_ANI,
+    K_ANI = TOKEN_KIND(CAT_KEYWORD, 0),
     K_TANIM,
     K_PARA,
     K_HABANG,
@@ -34,7 +43,7 @@ typedef enum {
 
 //Tokens for reserved words category:
 typedef enum {
-    R_TAMA,
+    R_TAMA = TOKEN_KIND(CAT_RESERVED, 0),
     R_MALI,
     R_UGAT,    
     R_BALIK, 
@@ -53,7 +62,7 @@ typedef enum {
 
 //Tokens for noisewords category:
 typedef enum {
-    N_NG,
+    N_NG = TOKEN_KIND(CAT_NOISEWORD, 0),
     N_AY,
     N_BUNGA,
     N_WAKAS,
@@ -65,7 +74,7 @@ typedef enum {
 
 //Tokens for operators category:
 typedef enum {
-    O_PLUS,        // +
+    O_PLUS = TOKEN_KIND(CAT_OPERATOR, 0),  // +
     O_MINUS,       // -
     O_MULTIPLY,    // *
     O_DIVIDE,      // /
@@ -85,7 +94,7 @@ typedef enum {
 
 //Tokens for delimiters category:
 typedef enum {
-    D_LPAREN,      // (
+    D_LPAREN = TOKEN_KIND(CAT_DELIMITER, 0),  // (
     D_RPAREN,      // )
     D_LBRACE,      // {
     D_RBRACE,      // }
@@ -101,7 +110,7 @@ typedef enum {
 
 //Tokens for literals category:
 typedef enum {
-    L_IDENTIFIER,
+    L_IDENTIFIER = TOKEN_KIND(CAT_LITERAL, 0),
     L_BILANG_LITERAL,
     L_LUTANG_LITERAL,
     L_KWERDAS_LITERAL,
@@ -112,17 +121,35 @@ typedef enum {
 
 //Tokens for comments category:
 typedef enum {
-    C_SINGLE_LINE,  // //
+    C_SINGLE_LINE = TOKEN_KIND(CAT_COMMENT, 0),  // //
     C_MULTI_LINE    // /* */
 } CommentToken;
 
+//Kind of every token in CAT_UNKNOWN
+typedef enum {
+    U_UNKNOWN = TOKEN_KIND(CAT_UNKNOWN, 0),
+    U_END_OF_INPUT  // never lexed: what the parser sees after the last token
+} UnknownToken;
+
 //General structure for a Token
 typedef struct {
     TokenCategory category;
-    int tokenValue;          // Holds actual enum value from KeywordToken, OperatorToken, etc.
+    int tokenValue;          // Token kind: enum value from KeywordToken, OperatorToken, etc.
     char* lexeme;         // The actual string from the source code
     int lineNumber;    // Line number in source code
 } Token;
 
+//Compact token that owns no memory: the lexeme is the slice
+//[offset, offset + length) of the source buffer it was lexed from.
+typedef struct {
+    uint32_t offset;      // byte offset of the lexeme in the source
+    uint32_t length;      // lexeme length in bytes
+    uint32_t lineNumber;  // Line number in source code
+    uint8_t category;     // TokenCategory
+    uint8_t tokenValue;   // token kind: enum value from KeywordToken, OperatorToken, etc.
+} TokenSpan;              // 16 bytes
+
+//longest source a TokenSpan can point into: offsets past it would wrap
+#define TOKEN_SOURCE_MAX UINT32_MAX
 
-#endif 
\ No newline at end of file
+#endif
\ No newline at end of file
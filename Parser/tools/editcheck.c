@@ -0,0 +1,234 @@
+//Checks incremental re-parsing against parsing from scratch: applies random
+//edits to a source file, brings the tokens and parse up to date with
+//relex() and incReparse(), and compares what incParsePrint() prints with
+//the output of a full parseProgram() of the new text. The summary line
+//gives what an edit costs: tokens parsed, segments and diagnostics
+//shifted behind it, and the time of relex() and incReparse() next to the
+//time of a full lex and parse.
+//Build and run from the Parser folder:
+//  gcc -O2 -pthread tools/editcheck.c parser.c ast.c incparse.c $(ls ../Lexer/*.c | grep -v main.c) -o editcheck
+//  ./editcheck file.usb [edits] [seed]
+//Prints the first mismatches and exits 1 if there were any.
+#define _POSIX_C_SOURCE 200809L  // open_memstream
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../parser.h"
+#include "../incparse.h"
+#include "../../Lexer/relex.h"
+#include "../../Lexer/source.h"
+
+#define SHOWN_MISMATCHES 3
+
+//small fixed generator so a seed gives the same edits everywhere
+static unsigned long long randomState;
+
+static size_t randomBelow(size_t bound) {
+    randomState = randomState * 6364136223846793005ull + 1442695040888963407ull;
+    return bound ? (size_t)(randomState >> 33) % bound : 0;
+}
+
+//text an edit puts in: whole statements and function edges as well as
+//pieces that split tokens
+static const char *const insertions[] = {
+    "", "a", "\n", "/*", "*/", "\"", "//", "kung", "1.5", "&&", ";", "{", "}", "(",
+    " x = 1 ;\n", " bilang q = 2 ;\n", "}\nwala ugat ( ) {\n", "wala ugat ( ) {\n",
+    " habang ( x < 2 ) { x = x + 1 ; }\n", " y = ( x ;\n", "// c\n", "kundi { }"
+};
+
+//whole lines for inside a body, the last one in error
+static const char *const statements[] = {
+    " x = 1 ;\n", " bilang q = 2 ;\n", " habang ( x < 2 ) { x = x + 1 ; }\n",
+    "}\nwala ugat ( ) {\n", " // c\n", " y = ( x ;\n"
+};
+
+static void lexAll(const char *source, size_t length, TokenList *list) {
+    LexerCtx ctx;
+    TokenSpan tok;
+    memset(list, 0, sizeof(*list));
+    lexer_init(&ctx, source, length);
+    while (lexer_next(&ctx, &tok))
+        tokenListPush(list, &tok);
+}
+
+static FILE *openText(char **text, size_t *length) {
+    FILE *file = open_memstream(text, length);
+    if (!file) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(2);
+    }
+    return file;
+}
+
+//parseProgram() output for source
+static char *fullParse(const char *source, size_t length, size_t *outLength) {
+    char *text;
+    FILE *file = openText(&text, outLength);
+    LexerCtx lexer;
+    setParserOutput(file);
+    lexer_init(&lexer, source, length);
+    attachLexer(&lexer);
+    parseProgram();
+    freeTokens();
+    setParserOutput(NULL);
+    fclose(file);
+    return text;
+}
+
+static char *incrementalParse(const IncParse *parse, const TokenList *tokens, const char *source,
+                              size_t *outLength) {
+    char *text;
+    FILE *file = openText(&text, outLength);
+    incParsePrint(parse, tokens, source, file);
+    fclose(file);
+    return text;
+}
+
+//1 if both ways of parsing source print the same; *fullTime gains the
+//time of the full parse
+static int sameOutput(const IncParse *parse, const TokenList *tokens, const char *source, size_t length,
+                      clock_t *fullTime) {
+    size_t fullLength, incLength;
+    clock_t start = clock();
+    char *full = fullParse(source, length, &fullLength);
+    *fullTime += clock() - start;
+    char *inc = incrementalParse(parse, tokens, source, &incLength);
+    int same = fullLength == incLength && memcmp(full, inc, fullLength) == 0;
+    free(full);
+    free(inc);
+    return same;
+}
+
+//the text being edited, its tokens and parse, and what the edits cost
+typedef struct {
+    char *text;
+    size_t length;
+    TokenList tokens;
+    IncParse parse;
+    int applied, mismatches;
+    size_t parsedTokens, shifted;
+    clock_t editTime, fullTime;
+} Checker;
+
+//replace removed bytes at offset with inserted, bring the parse up to date
+//incrementally and compare it with a full parse
+static void applyEdit(Checker *c, size_t offset, size_t removed, const char *inserted, size_t insertedLength) {
+    RelexEdit edit = { offset, removed, insertedLength };
+    size_t newLength = c->length - removed + insertedLength;
+    char *edited = malloc(newLength + 1);
+    if (!edited) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(2);
+    }
+    memcpy(edited, c->text, offset);
+    memcpy(edited + offset, inserted, insertedLength);
+    memcpy(edited + offset + insertedLength, c->text + offset + removed, c->length - offset - removed);
+
+    clock_t start = clock();
+    RelexResult result = relex(&c->tokens, edited, newLength, &edit);
+    incReparse(&c->parse, &c->tokens, edited, &result);
+    c->editTime += clock() - start;
+    c->parsedTokens += c->parse.parsedTokens;
+    c->shifted += c->parse.shifted;
+    if (!sameOutput(&c->parse, &c->tokens, edited, newLength, &c->fullTime)) {
+        if (c->mismatches < SHOWN_MISMATCHES)
+            printf("edit %d (offset %zu, removed %zu, inserted '%.*s'): output differs\n",
+                   c->applied, offset, removed, (int)insertedLength, inserted);
+        c->mismatches++;
+        incParseFull(&c->parse, &c->tokens, edited); //carry on from the right parse
+    }
+    c->applied++;
+    free(c->text);
+    c->text = edited;
+    c->length = newLength;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: editcheck file.usb [edits] [seed]\n");
+        return 2;
+    }
+    int edits = argc > 2 ? atoi(argv[2]) : 1000;
+    randomState = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+
+    FILE *file = fopen(argv[1], "r");
+    SourceBuffer src;
+    if (!file || sourceLoad(&src, file) != 0) {
+        fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 2;
+    }
+    fclose(file);
+    initialize_lexer();
+
+    Checker c;
+    memset(&c, 0, sizeof(c));
+    c.length = src.length;
+    c.text = malloc(c.length + 1);
+    if (!c.text) {
+        fprintf(stderr, "Error: out of memory\n");
+        return 2;
+    }
+    memcpy(c.text, src.data, c.length);
+    sourceRelease(&src);
+
+    lexAll(c.text, c.length, &c.tokens);
+    incParseInit(&c.parse);
+    incParseFull(&c.parse, &c.tokens, c.text);
+    if (!sameOutput(&c.parse, &c.tokens, c.text, c.length, &c.fullTime)) {
+        printf("first parse differs\n");
+        c.mismatches++;
+    }
+    c.fullTime = 0;
+
+    char *removedText = NULL;
+    for (int i = 0; i < edits; i++) {
+        size_t offset, removed;
+        const char *inserted;
+        //one edit in eight at the very start, where the first function is
+        offset = randomBelow(8) ? randomBelow(c.length + 1) : 0;
+        if (randomBelow(2) && offset < c.length) {
+            //a whole line inside a body, so the text stays mostly valid and
+            //edits keep landing in code that is parsed
+            while (offset > 0 && c.text[offset - 1] != '\n')
+                offset--;
+            size_t end = offset;
+            while (end < c.length && c.text[end] != '\n')
+                end++;
+            int inBody = c.text[offset] == ' ';
+            int remove = inBody && randomBelow(2);
+            removed = remove ? end + (end < c.length) - offset : 0;
+            inserted = inBody && !remove ? statements[randomBelow(sizeof(statements) / sizeof(statements[0]))] : "";
+        } else {
+            removed = randomBelow(6);
+            if (offset + removed > c.length)
+                removed = c.length - offset;
+            inserted = insertions[randomBelow(sizeof(insertions) / sizeof(insertions[0]))];
+        }
+
+        char *kept = realloc(removedText, removed + 1);
+        if (!kept) {
+            fprintf(stderr, "Error: out of memory\n");
+            return 2;
+        }
+        removedText = kept;
+        memcpy(removedText, c.text + offset, removed);
+        applyEdit(&c, offset, removed, inserted, strlen(inserted));
+        //an edit that broke the program is checked, then undone (and that
+        //checked too), so errors do not pile up until nothing after the
+        //first one is parsed
+        if (incParseErrorCount(&c.parse) > 0 || c.parse.stop < c.tokens.count)
+            applyEdit(&c, offset, strlen(inserted), removedText, removed);
+    }
+    free(removedText);
+
+    double perEdit = c.applied ? 1.0 / c.applied : 0.0;
+    printf("%d edits (%d with undos), %d mismatches, per edit: %.1f tokens parsed, %.0f segments and "
+           "diagnostics shifted, %.1f us to re-lex and re-parse against %.1f us for a full lex and parse\n",
+           edits, c.applied, c.mismatches, c.parsedTokens * perEdit, c.shifted * perEdit,
+           c.editTime * perEdit * 1e6 / CLOCKS_PER_SEC, c.fullTime * perEdit * 1e6 / CLOCKS_PER_SEC);
+    incParseFree(&c.parse);
+    tokenListFree(&c.tokens);
+    free(c.text);
+    return c.mismatches ? 1 : 0;
+}